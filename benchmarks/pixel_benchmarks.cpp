@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "pixel.hpp"
+
+namespace {
+// A page at 150 DPI
+constexpr int WIDTH = 1275;
+constexpr int HEIGHT = 1650;
+
+std::vector<std::uint32_t> noise(std::size_t n) {
+    std::mt19937 rng(1);
+    std::vector<std::uint32_t> px(n);
+    for (auto& p : px) {
+        p = rng();
+    }
+    return px;
+}
+
+// Use the instruction set of the benchmark argument, skipping it if the CPU lacks it
+bool use(benchmark::State& state) {
+    static const char* const names[] = {"scalar", "sse2", "avx2"};
+    const auto wanted = static_cast<yapdf::Simd>(state.range(0));
+    if (yapdf::useSimd(wanted) != wanted) {
+        state.SkipWithError("Unsupported instruction set");
+        return false;
+    }
+    state.SetLabel(names[state.range(0)]);
+    return true;
+}
+
+template <typename F>
+void run(benchmark::State& state, std::size_t bytesPerPixel, F&& f) {
+    for (auto _ : state) {
+        for (int y = 0; y < HEIGHT; ++y) {
+            f(y);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * WIDTH * HEIGHT * static_cast<std::int64_t>(bytesPerPixel));
+    yapdf::useSimd(yapdf::detectSimd());
+}
+} // namespace
+
+static void BM_premultiply(benchmark::State& state) {
+    if (!use(state)) {
+        return;
+    }
+
+    std::vector<std::uint32_t> px = noise(static_cast<std::size_t>(WIDTH) * HEIGHT);
+    run(state, 4, [&](int y) { yapdf::premultiply(px.data() + static_cast<std::size_t>(WIDTH) * y, WIDTH); });
+}
+BENCHMARK(BM_premultiply)->DenseRange(0, 2);
+
+static void BM_unpremultiply(benchmark::State& state) {
+    if (!use(state)) {
+        return;
+    }
+
+    std::vector<std::uint32_t> px = noise(static_cast<std::size_t>(WIDTH) * HEIGHT);
+    run(state, 4, [&](int y) { yapdf::unpremultiply(px.data() + static_cast<std::size_t>(WIDTH) * y, WIDTH); });
+}
+BENCHMARK(BM_unpremultiply)->DenseRange(0, 2);
+
+static void BM_toArgb32(benchmark::State& state) {
+    if (!use(state)) {
+        return;
+    }
+
+    const std::vector<std::uint32_t> src = noise(static_cast<std::size_t>(WIDTH) * HEIGHT);
+    const auto* rgb = reinterpret_cast<const std::uint8_t*>(src.data());
+    std::vector<std::uint32_t> dst(static_cast<std::size_t>(WIDTH) * HEIGHT);
+    run(state, 3, [&](int y) {
+        const std::size_t offset = static_cast<std::size_t>(WIDTH) * y;
+        yapdf::toArgb32(yapdf::PixelFormat::Rgb24, rgb + 3 * offset, dst.data() + offset, WIDTH);
+    });
+}
+BENCHMARK(BM_toArgb32)->DenseRange(0, 2);
+
+static void BM_toRgb24(benchmark::State& state) {
+    if (!use(state)) {
+        return;
+    }
+
+    const std::vector<std::uint32_t> src = noise(static_cast<std::size_t>(WIDTH) * HEIGHT);
+    std::vector<std::uint8_t> dst(static_cast<std::size_t>(WIDTH) * HEIGHT * 3);
+    run(state, 4, [&](int y) {
+        const std::size_t offset = static_cast<std::size_t>(WIDTH) * y;
+        yapdf::toRgb24(src.data() + offset, dst.data() + 3 * offset, WIDTH);
+    });
+}
+BENCHMARK(BM_toRgb24)->DenseRange(0, 2);
@@ -0,0 +1,97 @@
+//! Wait for background work without freezing Emacs
+//!
+//! A module function runs on the Emacs main thread, so a long synchronous computation locks Emacs up until it
+//! finishes and <kbd>C-g</kbd> does nothing. Instead, the work is submitted to the `ThreadPool` and the calling module
+//! function `await`s its future. While waiting, `await` periodically asks Emacs whether the user wants to quit. If so,
+//! the job is cancelled through its `CancellationToken` and the `quit` signal is handed back to the caller, who should
+//! return it to Emacs as soon as possible.
+//!
+//! # Examples
+//!
+//! ``` cpp
+//! Expected<Value, Error> slow(Env& e, Value args[], std::size_t n) {
+//!     CancellationToken token;
+//!     auto fut = ThreadPool::getInstance().submit([token] { return compute(token); });
+//!     YAPDF_TRY(await(e, fut, token));
+//!     return e.make<Value::Type::String>(fut.get());
+//! }
+//! ```
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_AWAIT_HPP_
+#define YAPDF_AWAIT_HPP_
+
+#include <chrono>
+#include <future>
+
+#include "bridge.hpp"
+#include "cancellation.hpp"
+
+namespace yapdf {
+namespace emacs {
+/// How often `await` checks for a pending quit.
+inline constexpr std::chrono::milliseconds AWAIT_POLL_INTERVAL(20);
+
+namespace internal {
+// Check whether the user wants to quit.
+//
+// `quit` can only be detected since Emacs 26.
+inline bool quitRequested(Env& e) noexcept {
+#if EMACS_MAJOR_VERSION >= 27
+    // `process_input` leaves a pending `quit` signal behind when it returns `Quit`
+    return e.processInput() == ProcessInputResult::Quit;
+#elif EMACS_MAJOR_VERSION >= 26
+    return e.shouldQuit();
+#else
+    (void)e;
+    return false;
+#endif
+}
+
+// Take the pending `quit` signal, or make one if there's none.
+inline Expected<Error, Error> quitError(Env& e) noexcept {
+    if (e.checkError() != FuncallExit::Return) {
+        const Error err = e.getError();
+        e.clearError();
+        return err;
+    }
+
+    const Value sym = YAPDF_TRY(e.intern("quit"));
+    const Value data = YAPDF_TRY(e.intern("nil"));
+    return Error(FuncallExit::Signal, sym, data);
+}
+} // namespace internal
+
+/// Block until `fut` is ready or the user quits.
+///
+/// `Future` is `std::future` or `std::shared_future`. On quit the job keeps running, which suits jobs whose result
+/// is shared or worth keeping (e.g. a rendered page going into a cache). The returned error is the `quit` signal and
+/// should be reported to Emacs unchanged.
+template <typename Future>
+Expected<Void, Error> await(Env& e, const Future& fut) noexcept {
+    while (fut.wait_for(AWAIT_POLL_INTERVAL) != std::future_status::ready) {
+        if (YAPDF_UNLIKELY(internal::quitRequested(e))) {
+            return Unexpected(YAPDF_TRY(internal::quitError(e)));
+        }
+    }
+    return Void{};
+}
+
+/// Block until `fut` is ready, cancelling `token` if the user quits in the meantime.
+///
+/// On quit, `await` waits for the job to notice the cancellation before returning, so the job may safely refer to
+/// objects owned by the caller.
+template <typename Future>
+Expected<Void, Error> await(Env& e, const Future& fut, const CancellationToken& token) noexcept {
+    Expected<Void, Error> result = await(e, fut);
+    if (YAPDF_UNLIKELY(result.hasError())) {
+        token.cancel();
+        fut.wait();
+    }
+    return result;
+}
+} // namespace emacs
+} // namespace yapdf
+
+#endif // YAPDF_AWAIT_HPP_
@@ -0,0 +1,102 @@
+//! Pooled image buffers
+//!
+//! Pages rendered at the same scale are almost always the same size, tens of megabytes each. Allocating and freeing
+//! them for every render fragments the heap and faults every page of the buffer in again. `BufferPool` maps large
+//! buffers directly, rounds them up to size classes, and keeps freed ones for the next image of the same class.
+//!
+//! Idle buffers are handed back with `MADV_FREE` where available: the kernel reclaims their memory only under memory
+//! pressure, and reusing a buffer it didn't reclaim costs nothing. Elsewhere `MADV_DONTNEED` reclaims it right away.
+//! The pool is bounded in bytes, and `trim` unmaps all idle buffers.
+//!
+//! Buffers of a huge page or more are aligned to one, so that transparent huge pages can back all of them.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_BUFFER_POOL_HPP_
+#define YAPDF_BUFFER_POOL_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace yapdf {
+/// Buffers smaller than this are allocated with `new`, they don't fragment the heap much.
+inline constexpr std::size_t BUFFER_POOL_MIN_SIZE = std::size_t(1) << 20;
+
+/// The size of a huge page, buffers at least this large are rounded up to a multiple of it.
+inline constexpr std::size_t BUFFER_POOL_HUGE_PAGE = std::size_t(2) << 20;
+
+/// The default budget of the idle buffers of `BufferPool`.
+inline constexpr std::size_t BUFFER_POOL_CAPACITY = std::size_t(128) << 20;
+
+/// Size-classed buffers reused across images.
+class BufferPool {
+public:
+    /// Give a buffer back to the pool it came from.
+    class Release {
+    public:
+        Release() noexcept = default;
+
+        Release(BufferPool* pool, std::size_t bytes) noexcept : pool_(pool), bytes_(bytes) {}
+
+        void operator()(std::uint8_t* p) const noexcept {
+            pool_->release(p, bytes_);
+        }
+
+    private:
+        BufferPool* pool_ = nullptr;
+        std::size_t bytes_ = 0;
+    };
+
+    using Buffer = std::unique_ptr<std::uint8_t[], Release>;
+
+    /// Return the pool of all images. It's never destroyed, so that images may outlive static destructors.
+    static BufferPool& getInstance() noexcept;
+
+    /// Keep up to `capacity` bytes of idle buffers.
+    explicit BufferPool(std::size_t capacity) noexcept : capacity_(capacity) {}
+
+    /// Unmap the idle buffers. Buffers in use must be released first.
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /// Return the size class of a buffer of `bytes`.
+    [[nodiscard]] static std::size_t sizeClass(std::size_t bytes) noexcept;
+
+    /// Return an uninitialized buffer of at least `bytes`, an idle one of the same size class if there's one.
+    ///
+    /// Throw `std::bad_alloc` if memory is exhausted.
+    [[nodiscard]] Buffer acquire(std::size_t bytes);
+
+    /// Unmap all idle buffers, returning their memory to the OS right away.
+    void trim() noexcept;
+
+    /// Return the total size of the idle buffers.
+    [[nodiscard]] std::size_t idle() const noexcept;
+
+    /// Advise the kernel to back new buffers with transparent huge pages, which saves TLB misses when drawing large
+    /// pages but may use more memory.
+    void hugePages(bool enable) noexcept {
+        hugePages_.store(enable, std::memory_order_relaxed);
+    }
+
+private:
+    void release(std::uint8_t* p, std::size_t bytes) noexcept;
+
+    std::size_t capacity_;
+    std::atomic<bool> hugePages_{false};
+
+    mutable std::mutex mu_;
+    std::size_t idle_ = 0;
+    // Idle buffers by size class, most recently released last
+    std::map<std::size_t, std::vector<std::uint8_t*>> free_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_BUFFER_POOL_HPP_
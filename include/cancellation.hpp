@@ -0,0 +1,49 @@
+//! Cooperative cancellation
+//!
+//! A `CancellationToken` is a cheap, copyable handle to a shared flag. The party that starts a long-running job keeps
+//! one copy and hands another to the job. The job polls `cancelled()` at convenient points (e.g. between pages) and
+//! returns early once it's set.
+//!
+//! # Examples
+//!
+//! ``` cpp
+//! CancellationToken token;
+//! auto fut = pool.submit([token] {
+//!     for (int i = 0; i < n && !token.cancelled(); ++i) {
+//!         work(i);
+//!     }
+//! });
+//!
+//! token.cancel();
+//! ```
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_CANCELLATION_HPP_
+#define YAPDF_CANCELLATION_HPP_
+
+#include <atomic>
+#include <memory>
+
+namespace yapdf {
+/// A shared cancellation flag. All copies of a token observe the same state.
+class CancellationToken {
+public:
+    CancellationToken() : cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    /// Request cancellation. It's only a request, the job decides when to stop.
+    void cancel() const noexcept {
+        cancelled_->store(true, std::memory_order_relaxed);
+    }
+
+    /// Check whether cancellation has been requested.
+    [[nodiscard]] bool cancelled() const noexcept {
+        return cancelled_->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_CANCELLATION_HPP_
@@ -0,0 +1,42 @@
+//! Streaming output to Emacs
+//!
+//! `Env::openChannel` turns a pipe process into a file descriptor that may be written from any thread, even while no
+//! module function is running. Emacs reads it in its event loop and feeds the output to the process filter, so jobs on
+//! `ThreadPool` can report results as they're produced instead of blocking the main thread.
+//!
+//! Messages are lines holding one s-expression each, e.g. `(thumbnail 3 91 128)`, so the filter can `read` them and
+//! dispatch on the head symbol.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_CHANNEL_HPP_
+#define YAPDF_CHANNEL_HPP_
+
+#include <mutex>
+#include <string_view>
+
+namespace yapdf {
+/// A write end of a pipe process, shared by the jobs reporting to it.
+class Channel {
+public:
+    /// Take ownership of `fd`, as returned by `Env::openChannel`.
+    explicit Channel(int fd) noexcept : fd_(fd) {}
+
+    ~Channel();
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    /// Write `msg` in full. Messages of concurrent writers never interleave.
+    ///
+    /// Return false if the process is gone, later writes are dropped.
+    bool write(std::string_view msg) noexcept;
+
+private:
+    std::mutex mu_;
+    int fd_;
+    bool broken_ = false;
+};
+} // namespace yapdf
+
+#endif // YAPDF_CHANNEL_HPP_
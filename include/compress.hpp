@@ -0,0 +1,34 @@
+//! Lossless compression of ARGB32 pixels
+//!
+//! Rendered pages are dominated by long runs of the paper color, which a run-length encoding of whole pixels shrinks
+//! by two orders of magnitude at a fraction of the cost of a general purpose compressor.
+//!
+//! The encoding is a sequence of chunks, each starting with a control byte `c`:
+//!
+//! | `c`        | Chunk                                             |
+//! |------------|---------------------------------------------------|
+//! | [0, 128)   | `c + 1` literal pixels follow, 4 bytes each       |
+//! | [128, 256) | one pixel follows, repeated `c - 127` times       |
+//!
+//! Pixels are stored in native byte order.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_COMPRESS_HPP_
+#define YAPDF_COMPRESS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace yapdf {
+/// Compress `n` pixels starting at `px`, appending the encoding to `out`.
+void compressPixels(const std::uint32_t* px, std::size_t n, std::vector<std::uint8_t>& out);
+
+/// Decompress exactly `n` pixels from `src` of `len` bytes into `px`.
+///
+/// Return false if `src` is corrupted or doesn't hold exactly `n` pixels.
+bool decompressPixels(const std::uint8_t* src, std::size_t len, std::uint32_t* px, std::size_t n) noexcept;
+} // namespace yapdf
+
+#endif // YAPDF_COMPRESS_HPP_
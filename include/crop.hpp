@@ -0,0 +1,36 @@
+//! Automatic margin cropping
+//!
+//! Two-column papers on a laptop screen waste a third of it on margins. The content box of a page is found by
+//! rendering it at a low resolution and scanning the rows for pixels that aren't paper, see `foregroundSpan`. Finding
+//! it is far too slow to do per draw, so `Document::content` caches it per page, and `Layout::scanContent` lays pages
+//! out by it.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_CROP_HPP_
+#define YAPDF_CROP_HPP_
+
+#include <cstdint>
+
+#include "image.hpp"
+#include "text.hpp"
+
+namespace yapdf {
+/// The scale pages are rendered at to find their content, 36 DPI.
+inline constexpr double CROP_SCALE = 0.5;
+
+/// How far a channel may be from the paper color to still count as paper, e.g. for noise of scanned pages.
+inline constexpr int CROP_TOLERANCE = 24;
+
+/// The margin kept around the content, in points.
+inline constexpr double CROP_PADDING = 6.0;
+
+/// The paper color of rendered pages.
+inline constexpr std::uint32_t CROP_BACKGROUND = 0xffffffff;
+
+/// Return the box of the pixels of `img` that aren't `CROP_BACKGROUND`, padded by `CROP_PADDING` and clamped to the
+/// page, in points of the page rendered at `scale`. A blank page is its own content.
+Box contentBox(const Image& img, double scale) noexcept;
+} // namespace yapdf
+
+#endif // YAPDF_CROP_HPP_
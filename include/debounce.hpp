@@ -0,0 +1,44 @@
+//! Debouncing
+//!
+//! Some requests come in bursts, e.g. one zoom step per key repeat, and only the last one of a burst is worth acting
+//! on. A `Debouncer` defers a call until no other call has been made for a while, each call replacing the pending one.
+//! Deferred calls run on a thread of the debouncer, which is started on first use.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_DEBOUNCE_HPP_
+#define YAPDF_DEBOUNCE_HPP_
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace yapdf {
+class Debouncer {
+public:
+    /// Calls are made once no other call has been made for `delay`.
+    explicit Debouncer(std::chrono::milliseconds delay) noexcept;
+
+    /// Drop the pending call. A call already running finishes on its own.
+    ~Debouncer();
+
+    Debouncer(const Debouncer&) = delete;
+    Debouncer& operator=(const Debouncer&) = delete;
+
+    /// Call `f` after the delay, unless `call` or `cancel` is called again before. Exceptions thrown by `f` are
+    /// ignored.
+    void call(std::function<void()> f);
+
+    /// Drop the pending call.
+    void cancel() noexcept;
+
+private:
+    struct State;
+
+    std::chrono::milliseconds delay_;
+    // Shared with the thread, which outlives the debouncer while a call is running
+    std::shared_ptr<State> state_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_DEBOUNCE_HPP_
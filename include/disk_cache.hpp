@@ -0,0 +1,83 @@
+//! Persistent on-disk cache of rendered pages
+//!
+//! Pages are stored one file per page, compressed with `compressPixels`, under a cache directory shared by all Emacs
+//! processes (`~/.cache/yapdf` by default). A memory-mapped index records which pages exist and when they were last
+//! used, so a lookup costs no file system access on a miss, and the least recently used pages are removed once the
+//! cache grows over its budget.
+//!
+//! Pages are keyed by the content hash of the file, so a modified file never hits stale pages and a copied or renamed
+//! file still hits.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_DISK_CACHE_HPP_
+#define YAPDF_DISK_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "image.hpp"
+#include "render.hpp"
+
+namespace yapdf {
+class DiskCache {
+public:
+    /// Return the default cache directory, `$XDG_CACHE_HOME/yapdf` or `~/.cache/yapdf`.
+    static std::string defaultDirectory();
+
+    /// Return the cache used by all renderers, or `nullptr` if the disk cache is disabled.
+    static std::shared_ptr<DiskCache> global() noexcept;
+
+    /// Set the cache used by all renderers, `nullptr` disables it.
+    static void global(std::shared_ptr<DiskCache> cache) noexcept;
+
+    /// Open or create the cache in `dir`, keeping the total size of the pages under `capacity` bytes.
+    ///
+    /// Throw `std::system_error` if the directory or its index can't be created.
+    DiskCache(const std::string& dir, std::size_t capacity);
+
+    ~DiskCache();
+
+    DiskCache(const DiskCache&) = delete;
+    DiskCache& operator=(const DiskCache&) = delete;
+
+    /// Load the page identified by `key` of the file whose content hash is `doc`.
+    ///
+    /// Return `nullptr` on a miss. I/O errors and corrupted entries are treated as misses.
+    std::shared_ptr<Image> load(std::uint64_t doc, const RenderKey& key) noexcept;
+
+    /// Store a page, evicting the least recently used pages if the cache grows over its budget.
+    ///
+    /// Errors are ignored, the cache is only an optimization.
+    void store(std::uint64_t doc, const RenderKey& key, const Image& img) noexcept;
+
+private:
+    struct Header;
+    struct Slot;
+
+    // Return the slot of the key, or an empty slot to insert it into, or `nullptr` if the index is full
+    Slot* find(std::uint64_t doc, const RenderKey& key) noexcept;
+
+    // Remove the slot and its page
+    void erase(Slot* slot) noexcept;
+
+    // Remove least recently used pages until `bytes` more bytes and one more slot fit
+    void evict(std::size_t bytes) noexcept;
+
+    std::string pathOf(const Slot& slot) const;
+
+    std::string dir_;
+    std::size_t capacity_;
+
+    // Threads of this process are serialized by `mu_`, processes by `flock` on the index
+    std::mutex mu_;
+    int fd_;
+    Header* header_;
+    Slot* slots_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_DISK_CACHE_HPP_
@@ -0,0 +1,164 @@
+//! An opened PDF document
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_DOCUMENT_HPP_
+#define YAPDF_DOCUMENT_HPP_
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <poppler/cpp/poppler-document.h>
+
+#include "cancellation.hpp"
+#include "mapped_file.hpp"
+#include "text.hpp"
+#include "text_cache.hpp"
+#include "thread_pool.hpp"
+
+namespace yapdf {
+class GlyphIndex;
+class Layout;
+class LinkMap;
+class TextIndex;
+
+/// The size of a page in points, as displayed.
+struct PageSize {
+    double width;
+    double height;
+};
+
+/// A PDF document loaded by poppler.
+///
+/// `Document` is shared between the Emacs main thread and the workers of `ThreadPool`. poppler documents must not be
+/// used by several threads at once, so all poppler calls go through `use`, which hands each worker of
+/// `ThreadPool::getInstance()` a `poppler::document` of its own. The instances are created lazily from one shared
+/// memory mapping of the file, so pages of the same document really render in parallel without multiplying the memory
+/// footprint of large files. Other threads share an instance behind a mutex.
+class Document {
+public:
+    /// Load the PDF file at `path`.
+    ///
+    /// Throw `std::runtime_error` if the file can't be read or loaded, or is locked by a password.
+    explicit Document(const std::string& path);
+
+    /// Return the path of the file.
+    [[nodiscard]] const std::string& path() const noexcept {
+        return path_;
+    }
+
+    /// Return the XXH64 hash of the file contents.
+    ///
+    /// It's computed on first use, which reads the whole file.
+    [[nodiscard]] std::uint64_t hash() const;
+
+    /// Return the number of pages.
+    [[nodiscard]] int pages() const noexcept {
+        return pages_;
+    }
+
+    /// Return the size of the 0-based `page`, rotated as displayed.
+    ///
+    /// Throw `std::runtime_error` if the page can't be loaded.
+    [[nodiscard]] PageSize size(int page) const;
+
+    /// Call `f` with exclusive access to a `poppler::document` of this document.
+    ///
+    /// Throw `std::runtime_error` if the worker's instance can't be loaded, or if the file was modified in place since
+    /// it was opened: poppler reads it lazily, and the changed file may be truncated (see mapped_file.hpp).
+    template <typename F>
+    decltype(auto) use(F&& f) const {
+        checkFile();
+        if (const int i = ThreadPool::getInstance().worker(); i >= 0) {
+            return std::forward<F>(f)(instance(i));
+        }
+
+        std::lock_guard<std::mutex> lock(mu_);
+        return std::forward<F>(f)(*doc_);
+    }
+
+    /// Return the text of the 0-based `page`.
+    ///
+    /// It's extracted on first use and cached with the text of the most recently used pages, since search,
+    /// selection and copy all need it again (see text_cache.hpp).
+    ///
+    /// Throw `std::out_of_range` if the page doesn't exist, or `std::runtime_error` if it can't be loaded.
+    [[nodiscard]] std::shared_ptr<const PageText> text(int page) const;
+
+    /// Return the spatial index of the glyphs of the 0-based `page`, built on first use from `text(page)` and cached
+    /// along with it.
+    ///
+    /// Throw like `text`.
+    [[nodiscard]] std::shared_ptr<const GlyphIndex> glyphs(int page) const;
+
+    /// Return the links of the 0-based `page`, recognized on first use in `text(page)` and cached along with it.
+    ///
+    /// Throw like `text`.
+    [[nodiscard]] std::shared_ptr<const LinkMap> links(int page) const;
+
+    /// Return the box of the content of the 0-based `page` in points, without its blank margins (see crop.hpp).
+    ///
+    /// It's found on first use by rendering the page at a low resolution, and cached. Concurrent calls for a page
+    /// share one rendering.
+    ///
+    /// Throw `std::out_of_range` if the page doesn't exist, or `std::runtime_error` if it can't be rendered.
+    [[nodiscard]] Box content(int page) const;
+
+    /// Return the text index attached by `TextIndex::load`, or `nullptr` if it isn't ready.
+    [[nodiscard]] std::shared_ptr<const TextIndex> index() const noexcept;
+
+    /// Attach a text index.
+    void index(std::shared_ptr<const TextIndex> idx) const noexcept;
+
+    /// Return the layout published by `Layout::scan`.
+    [[nodiscard]] std::shared_ptr<const Layout> layout() const noexcept;
+
+    /// Publish a layout.
+    void layout(std::shared_ptr<const Layout> layout) const noexcept;
+
+    /// Return the layout of the content boxes published by `Layout::scanContent`, or `nullptr` if it never ran.
+    [[nodiscard]] std::shared_ptr<const Layout> contentLayout() const noexcept;
+
+    /// Publish a layout of the content boxes.
+    void contentLayout(std::shared_ptr<const Layout> layout) const noexcept;
+
+    /// Return the text of pages [`first`, `last`), pages are separated by a form feed.
+    ///
+    /// `token` is checked between pages. Once it's cancelled, the text extracted so far is returned.
+    std::string text(int first, int last, const CancellationToken& token) const;
+
+private:
+    // Throw `std::runtime_error` if the file was modified since it was mapped
+    void checkFile() const;
+
+    // Return the instance of the `i`-th worker, loading it on first use. Only the worker itself touches its slot.
+    const poppler::document& instance(int i) const;
+
+    std::string path_;
+    // The file contents, poppler refers to it without copying
+    MappedFile file_;
+    std::unique_ptr<poppler::document> doc_;
+    mutable std::mutex mu_;
+    mutable std::vector<std::unique_ptr<poppler::document>> instances_;
+    int pages_;
+    // The text of recently used pages
+    mutable TextCache texts_;
+    // Content boxes, invalid until first use. A page is cropped once, concurrent callers wait for its future.
+    mutable std::mutex contentMu_;
+    mutable std::vector<std::shared_future<Box>> contents_;
+    // Set by a worker once built or loaded, use `std::atomic_load` and `std::atomic_store`
+    mutable std::shared_ptr<const TextIndex> index_;
+    // Published by workers as page sizes are read, use `std::atomic_load` and `std::atomic_store`
+    mutable std::shared_ptr<const Layout> layout_;
+    mutable std::shared_ptr<const Layout> contentLayout_;
+    mutable std::once_flag hashed_;
+    mutable std::uint64_t hash_ = 0;
+};
+} // namespace yapdf
+
+#endif // YAPDF_DOCUMENT_HPP_
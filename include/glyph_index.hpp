@@ -0,0 +1,63 @@
+//! Spatial index of the glyphs of a page
+//!
+//! Mouse clicks, hovering and drag selection all ask which glyphs lie under a point or a rectangle, once per motion
+//! event. A `GlyphIndex` buckets the glyph boxes of a page into a uniform grid sized for a few glyphs per cell, so such
+//! a query only looks at the glyphs of the cells it covers instead of every glyph of the page.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_GLYPH_INDEX_HPP_
+#define YAPDF_GLYPH_INDEX_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "text.hpp"
+
+namespace yapdf {
+/// The glyphs of a page bucketed by position, and its words.
+class GlyphIndex {
+public:
+    /// Index the glyphs of `text`.
+    explicit GlyphIndex(std::shared_ptr<const PageText> text);
+
+    /// Return the indexed text.
+    [[nodiscard]] const PageText& text() const noexcept {
+        return *text_;
+    }
+
+    /// Return the glyph whose box contains the point (`x`, `y`), or -1 if there's none.
+    [[nodiscard]] int at(float x, float y) const noexcept;
+
+    /// Return the glyph whose box is the nearest to the point (`x`, `y`), or -1 if the page has no glyph.
+    [[nodiscard]] int nearest(float x, float y) const noexcept;
+
+    /// Return the glyphs whose box intersects `box`, in reading order.
+    [[nodiscard]] std::vector<std::uint32_t> within(const Box& box) const;
+
+    /// Return the word of glyph `i` as the range of glyphs [first, last).
+    [[nodiscard]] std::pair<std::uint32_t, std::uint32_t> word(std::uint32_t i) const noexcept;
+
+private:
+    // Return the column and the row of the cell of (`x`, `y`), clamped to the grid
+    int column(float x) const noexcept;
+    int row(float y) const noexcept;
+
+    std::shared_ptr<const PageText> text_;
+    // The grid spans (0, 0) to (`width_`, `height_`), the extent of the glyphs
+    float width_ = 0;
+    float height_ = 0;
+    int columns_ = 1;
+    int rows_ = 1;
+    // The glyphs of cell `c` are `glyphs_[cells_[c]]` up to `glyphs_[cells_[c + 1]]`, in increasing order. A glyph
+    // is in every cell its box overlaps.
+    std::vector<std::uint32_t> cells_;
+    std::vector<std::uint32_t> glyphs_;
+    // The first glyph of every word
+    std::vector<std::uint32_t> words_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_GLYPH_INDEX_HPP_
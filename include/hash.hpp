@@ -0,0 +1,22 @@
+//! Non-cryptographic hashing
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_HASH_HPP_
+#define YAPDF_HASH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace yapdf {
+/// Hash `len` bytes at `p` with XXH64.
+///
+/// It runs at several GB/s, fast enough to identify a whole file by its content.
+///
+/// # Reference
+///
+/// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+std::uint64_t hash64(const void* p, std::size_t len, std::uint64_t seed = 0) noexcept;
+} // namespace yapdf
+
+#endif // YAPDF_HASH_HPP_
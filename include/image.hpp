@@ -0,0 +1,66 @@
+//! Raster images
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_IMAGE_HPP_
+#define YAPDF_IMAGE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "buffer_pool.hpp"
+
+namespace yapdf {
+/// An image in Cairo's ARGB32 format: each pixel is a native-endian 32-bit word with alpha in the upper 8 bits, then
+/// premultiplied red, green and blue.
+///
+/// The pixels are left uninitialized on construction. Large images take their buffer from `BufferPool`.
+class Image {
+public:
+    Image(int width, int height)
+        : width_(width), height_(height), stride_(width * 4), data_(BufferPool::getInstance().acquire(size())) {}
+
+    [[nodiscard]] int width() const noexcept {
+        return width_;
+    }
+
+    [[nodiscard]] int height() const noexcept {
+        return height_;
+    }
+
+    /// Return the number of bytes per row.
+    [[nodiscard]] int stride() const noexcept {
+        return stride_;
+    }
+
+    /// Return the number of bytes of the pixel data.
+    [[nodiscard]] std::size_t size() const noexcept {
+        return static_cast<std::size_t>(stride_) * height_;
+    }
+
+    [[nodiscard]] std::uint8_t* data() noexcept {
+        return data_.get();
+    }
+
+    [[nodiscard]] const std::uint8_t* data() const noexcept {
+        return data_.get();
+    }
+
+    /// Return the first pixel of row `y`.
+    [[nodiscard]] std::uint32_t* row(int y) noexcept {
+        return reinterpret_cast<std::uint32_t*>(data() + static_cast<std::size_t>(stride_) * y);
+    }
+
+    [[nodiscard]] const std::uint32_t* row(int y) const noexcept {
+        return reinterpret_cast<const std::uint32_t*>(data() + static_cast<std::size_t>(stride_) * y);
+    }
+
+private:
+    int width_;
+    int height_;
+    int stride_;
+    BufferPool::Buffer data_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_IMAGE_HPP_
@@ -0,0 +1,90 @@
+//! Continuous-scroll layout
+//!
+//! Pages are stacked vertically, centered, with a gap between them. The top of every page is kept as a prefix sum of
+//! the page heights in points, so the offset of a page at any scale is computed in O(1) and the page at a scroll
+//! position is found by binary search in O(log n). A zoom changes nothing but the scale the queries are given, and
+//! scrolling a 10,000-page document costs the same as scrolling a 10-page one. Only the pages `visible` returns need
+//! an image.
+//!
+//! Offsets are in pixels: page sizes are scaled, while the gap is a constant number of pixels.
+//!
+//! Every page size is needed, and reading them all takes a while for a large document. `scan` publishes a layout
+//! where all pages have the size of the first one right away, correct for most documents, then reads the others in
+//! chunks on `ThreadPool`, behind renders, and publishes a refined layout after 1, 2, 4, ... chunks are done and after
+//! the last one: each copies the whole layout. `scanContent` does the same for the layout of the pages cropped to
+//! their content (see crop.hpp), publishing after every chunk since cropping renders pages and is much slower.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_LAYOUT_HPP_
+#define YAPDF_LAYOUT_HPP_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "cancellation.hpp"
+#include "document.hpp"
+
+namespace yapdf {
+/// The vertical layout of the pages of a document.
+class Layout {
+public:
+    /// Publish the layout of `doc` to `Document::layout`, and refine it on `ThreadPool` as the page sizes are read.
+    ///
+    /// Once `token` is cancelled, the scan stops. A page whose size can't be read keeps the size of the first page.
+    static void scan(std::shared_ptr<Document> doc, const CancellationToken& token);
+
+    /// Publish a layout of the content boxes of the pages of `doc` to `Document::contentLayout`, starting from the
+    /// current `Document::layout`, and refine it on `ThreadPool` as the pages are cropped, those around `from` first.
+    /// Pages not cropped yet take their exact size once `scan` is done.
+    ///
+    /// Once `token` is cancelled, the scan stops. A page that can't be cropped keeps its full size.
+    static void scanContent(std::shared_ptr<Document> doc, int from, const CancellationToken& token);
+
+    /// Lay out pages of `sizes` in points.
+    explicit Layout(const std::vector<PageSize>& sizes);
+
+    /// Return true once `scan` has read the size of every page, or `scanContent` has cropped every page.
+    [[nodiscard]] bool exact() const noexcept {
+        return exact_;
+    }
+
+    [[nodiscard]] int pages() const noexcept {
+        return static_cast<int>(tops_.size()) - 1;
+    }
+
+    /// Return the size of `page` in points.
+    [[nodiscard]] PageSize size(int page) const noexcept {
+        return PageSize{widths_[page], tops_[page + 1] - tops_[page]};
+    }
+
+    /// Return the width and height of the whole layout at `scale` with `gap` pixels between pages.
+    [[nodiscard]] std::pair<double, double> extent(double scale, double gap) const noexcept;
+
+    /// Return the top of `page` at `scale` with `gap` pixels between pages.
+    [[nodiscard]] double offset(int page, double scale, double gap) const noexcept {
+        return tops_[page] * scale + page * gap;
+    }
+
+    /// Return the page at `y`, or in the gap above `y`, at `scale` with `gap` pixels between pages.
+    ///
+    /// `y` is clamped to the layout, so it's a valid page unless the document is empty.
+    [[nodiscard]] int pageAt(double y, double scale, double gap) const noexcept;
+
+    /// Return the pages [first, last) intersecting the `height` pixels from `top`.
+    [[nodiscard]] std::pair<int, int> visible(double top, double height, double scale, double gap) const noexcept;
+
+    /// Change the sizes of pages from `first` on to `sizes` in points, moving the pages below them.
+    void update(int first, const std::vector<PageSize>& sizes);
+
+private:
+    // `tops_[i]` is the sum of the heights of the pages before page `i`, in points
+    std::vector<double> tops_;
+    std::vector<double> widths_;
+    double width_ = 0;
+    bool exact_ = false;
+};
+} // namespace yapdf
+
+#endif // YAPDF_LAYOUT_HPP_
@@ -0,0 +1,53 @@
+//! Links of a page
+//!
+//! poppler-cpp doesn't expose link annotations, so links are recognized in the page text instead: URLs starting with
+//! a scheme (`http://`, `https://`, `ftp://`, `file://`, `mailto:`) or `www.`. A `LinkMap` is built once per page
+//! and answers hover lookups with a hit test on the `GlyphIndex` and a binary search over the links.
+//!
+//! Links inside the document, e.g. cross-references, are annotations only. They aren't recognized, so their target
+//! page can't be found nor rendered ahead of time. That takes a binding exposing link annotations and their
+//! destinations, which poppler-cpp doesn't have.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_LINKS_HPP_
+#define YAPDF_LINKS_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "text.hpp"
+
+namespace yapdf {
+/// A link covering a run of glyphs.
+struct Link {
+    /// The glyphs of the link [first, last)
+    std::uint32_t first;
+    std::uint32_t last;
+    /// The target URI
+    std::string uri;
+};
+
+/// The links of a page, sorted by glyph.
+class LinkMap {
+public:
+    /// Recognize the links of `text`.
+    static LinkMap extract(const PageText& text);
+
+    /// Make a map of `links`, which must not overlap.
+    explicit LinkMap(std::vector<Link> links);
+
+    /// Return the link covering `glyph`, or `nullptr`.
+    [[nodiscard]] const Link* at(std::uint32_t glyph) const noexcept;
+
+    [[nodiscard]] const std::vector<Link>& links() const noexcept {
+        return links_;
+    }
+
+private:
+    std::vector<Link> links_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_LINKS_HPP_
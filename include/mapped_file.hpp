@@ -0,0 +1,61 @@
+//! Read-only memory-mapped files
+//!
+//! A mapping refers to the file itself: reading past its end once the file has been truncated raises SIGBUS, which
+//! kills Emacs. Replacing a file by renaming another over it is safe, the mapping keeps the old one, but a file
+//! rewritten in place, e.g. a PDF a LaTeX run is regenerating, isn't. Readers check `changed` before reading, which
+//! leaves a window of a few instructions rather than the time it takes to render a page. Files known to be rewritten
+//! in place can be copied into memory instead.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_MAPPED_FILE_HPP_
+#define YAPDF_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace yapdf {
+/// A whole file mapped read-only into memory.
+///
+/// The pages are backed by the page cache, so any number of readers share one copy of the file no matter how large it
+/// is, and only the parts actually read are brought into memory.
+class MappedFile {
+public:
+    /// Map the file at `path`, or read it into memory if `copy` is true, which costs as much memory as the file.
+    ///
+    /// Throw `std::system_error` if the file can't be opened, mapped or read.
+    explicit MappedFile(const std::string& path, bool copy = false);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Return the first byte of the file, or `nullptr` if it's empty.
+    [[nodiscard]] const char* data() const noexcept {
+        return data_;
+    }
+
+    /// Return the size of the file in bytes, as it was when it was mapped or read.
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+
+    /// Return true if the mapped file was modified since it was mapped, and reading it may fault. A copy never
+    /// changes.
+    [[nodiscard]] bool changed() const noexcept;
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    // Kept open to check the mapped file itself, not whatever has been renamed over its path since
+    int fd_ = -1;
+    std::timespec mtime_{};
+    // The contents of a copied file, empty if it's mapped
+    std::vector<char> copy_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_MAPPED_FILE_HPP_
@@ -0,0 +1,98 @@
+//! Mipmap pyramids
+//!
+//! While zooming, a page is drawn at every intermediate scale. Rather than rasterizing each one, a recently viewed
+//! page is rendered once at the power of two scale at or above the one asked for, and halved down with `boxHalve`
+//! into a pyramid of levels. A scale is then drawn from the smallest level at or above it, shrinking by less than
+//! half, where bilinear interpolation still looks at every source pixel. Below the smallest level, it's halved
+//! further first.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_MIPMAP_HPP_
+#define YAPDF_MIPMAP_HPP_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "image.hpp"
+#include "render.hpp"
+
+namespace yapdf {
+/// The default budget of `MipmapCache`, a pyramid takes a third more than its base.
+inline constexpr std::size_t MIPMAP_CACHE_CAPACITY = std::size_t(128) << 20;
+
+/// Pyramids aren't built for larger scales, their base would be too big.
+inline constexpr double MIPMAP_MAX_SCALE = 4.0;
+
+/// Levels are halved until either dimension is below this many pixels.
+inline constexpr int MIPMAP_MIN_SIZE = 64;
+
+/// Return the scale of the base level of a pyramid drawing `scale`, the power of two at or above it.
+double mipmapBase(double scale) noexcept;
+
+/// A page rendered at a power of two scale and its successive halves.
+class Mipmap {
+public:
+    /// Build the levels below `base`, the page rendered for `key`.
+    Mipmap(const RenderKey& key, std::shared_ptr<const Image> base);
+
+    /// Return the key of the base level.
+    [[nodiscard]] const RenderKey& key() const noexcept {
+        return key_;
+    }
+
+    [[nodiscard]] std::size_t levels() const noexcept {
+        return levels_.size();
+    }
+
+    /// Return the size of all levels in bytes.
+    [[nodiscard]] std::size_t bytes() const noexcept {
+        return bytes_;
+    }
+
+    /// Return level `i`, at the scale of the base divided by `2^i`.
+    [[nodiscard]] const Image& level(std::size_t i) const noexcept {
+        return *levels_[i];
+    }
+
+    /// Return the smallest level at or above `scale` with its scale, which must not be larger than the scale of the
+    /// base.
+    [[nodiscard]] std::pair<double, std::shared_ptr<const Image>> nearest(double scale) const noexcept;
+
+    /// Draw the page at `scale`, which must not be larger than the scale of the base.
+    ///
+    /// It resamples the whole page, call it on a worker.
+    [[nodiscard]] std::unique_ptr<Image> draw(double scale) const;
+
+private:
+    RenderKey key_;
+    std::vector<std::shared_ptr<const Image>> levels_;
+    std::size_t bytes_ = 0;
+};
+
+/// The pyramids of the most recently used pages.
+class MipmapCache {
+public:
+    /// Keep pyramids up to `capacity` bytes, and at least the newest one.
+    explicit MipmapCache(std::size_t capacity) noexcept : capacity_(capacity) {}
+
+    /// Return a pyramid of `key.page` in the colors of `key` that can draw `key.scale`, or `nullptr`.
+    std::shared_ptr<const Mipmap> find(const RenderKey& key);
+
+    /// Keep `mipmap`, replacing the pyramid of the same page and colors.
+    void insert(std::shared_ptr<const Mipmap> mipmap);
+
+private:
+    std::mutex mu_;
+    std::size_t capacity_;
+    std::size_t used_ = 0;
+    // Most recently used first
+    std::list<std::shared_ptr<const Mipmap>> lru_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_MIPMAP_HPP_
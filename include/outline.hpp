@@ -0,0 +1,59 @@
+//! Document outline
+//!
+//! The table of contents of a large manual has tens of thousands of entries. It's read from poppler once, on a
+//! worker, and flattened into a preorder array, where every item records its depth and where its subtree ends. A
+//! subtree is then a contiguous range, and Lisp can fetch the top levels first and deeper levels as they're expanded.
+//!
+//! poppler-cpp doesn't expose the destinations of the entries, so their target pages aren't known.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_OUTLINE_HPP_
+#define YAPDF_OUTLINE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace poppler {
+class document;
+} // namespace poppler
+
+namespace yapdf {
+/// An entry of the outline.
+struct OutlineItem {
+    /// UTF-8 title
+    std::string title;
+    /// 0 for the top level
+    int depth;
+    /// Whether the entry is expanded initially
+    bool open;
+    /// The index of the next item that isn't a descendant
+    std::uint32_t end;
+};
+
+/// The outline of a document in preorder.
+class Outline {
+public:
+    /// Read the outline of `doc`, empty if it has none.
+    static Outline extract(const poppler::document& doc);
+
+    /// Make an outline of `items`, in preorder and with their `end` set.
+    explicit Outline(std::vector<OutlineItem> items) noexcept;
+
+    [[nodiscard]] const std::vector<OutlineItem>& items() const noexcept {
+        return items_;
+    }
+
+    /// Return the descendants of `item` at most `depth` levels below it, in preorder. An `item` of -1 stands for the
+    /// root of the outline, whose children are the top level.
+    ///
+    /// Throw `std::out_of_range` if `item` doesn't exist.
+    [[nodiscard]] std::vector<std::uint32_t> subtree(int item, int depth) const;
+
+private:
+    std::vector<OutlineItem> items_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_OUTLINE_HPP_
@@ -0,0 +1,93 @@
+//! Pixel kernels
+//!
+//! Kernels work on rows of ARGB32 pixels (see `Image`). The hot ones are vectorized with SSE2 where available, with a
+//! scalar fallback elsewhere.
+//!
+//! The format conversions, which run over every pixel of every rendered page, also have AVX2 versions. They're picked
+//! at runtime by `simd()`, so the library still loads on CPUs without AVX2.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_PIXEL_HPP_
+#define YAPDF_PIXEL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace yapdf {
+/// Layouts of pixel data that `toArgb32` converts from.
+enum class PixelFormat : std::uint8_t {
+    /// 1 byte of gray per pixel
+    Gray8,
+    /// 3 bytes per pixel, in memory order
+    Rgb24,
+    Bgr24,
+    /// Like `Image`, but not premultiplied
+    StraightArgb32,
+    /// Like `Image`
+    Argb32,
+};
+
+/// Instruction sets the dispatched kernels are implemented for.
+enum class Simd : std::uint8_t {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+/// Return the widest instruction set the CPU supports.
+Simd detectSimd() noexcept;
+
+/// Return the instruction set the dispatched kernels use, `detectSimd()` unless changed by `useSimd`.
+Simd simd() noexcept;
+
+/// Make the dispatched kernels use `level`, or the widest supported set below it, and return the one used.
+///
+/// It's meant for tests and benchmarks comparing the implementations.
+Simd useSimd(Simd level) noexcept;
+
+/// Convert `n` pixels of `format` at `src` to premultiplied ARGB32. Pixels of formats without alpha are opaque.
+void toArgb32(PixelFormat format, const std::uint8_t* src, std::uint32_t* dst, int n) noexcept;
+
+/// Convert `n` ARGB32 pixels to 3 bytes of red, green and blue each, dropping alpha.
+void toRgb24(const std::uint32_t* src, std::uint8_t* dst, int n) noexcept;
+
+/// Multiply the colors of `n` pixels by their alpha in place.
+void premultiply(std::uint32_t* row, int n) noexcept;
+
+/// Divide the colors of `n` premultiplied pixels by their alpha in place, rounding to nearest. Transparent pixels
+/// become 0.
+void unpremultiply(std::uint32_t* row, int n) noexcept;
+
+/// Downsample two rows by half in each direction with a 2x2 box filter.
+///
+/// `row0` and `row1` hold `2 * n` pixels each, `n` pixels are written to `out`.
+void boxHalve(const std::uint32_t* row0, const std::uint32_t* row1, std::uint32_t* out, int n) noexcept;
+
+/// Invert the lightness of `n` pixels in place, keeping their hue and saturation.
+///
+/// Pixels are premultiplied: each color channel `c` becomes `c + a - max(r, g, b) - min(r, g, b)`, which mirrors HSL
+/// lightness and leaves alpha alone.
+void invertLightness(std::uint32_t* row, int n) noexcept;
+
+/// Map the luminance of `n` pixels in place from `dark` (black) to `light` (white), both 0xRRGGBB.
+///
+/// Pixels are premultiplied, alpha is kept.
+void remapLuminance(std::uint32_t* row, int n, std::uint32_t dark, std::uint32_t light) noexcept;
+
+/// Return the columns [first, last) spanning the pixels of `row` that differ from `background` by more than
+/// `tolerance` in any channel, or (0, 0) if all `n` pixels are background.
+///
+/// Only the pixels from each end up to the first foreground one are read, so a row of text costs its margins.
+std::pair<int, int> foregroundSpan(const std::uint32_t* row, int n, std::uint32_t background, int tolerance) noexcept;
+
+/// Resize a `srcWidth` by `srcHeight` image to `dstWidth` by `dstHeight` with bilinear interpolation.
+///
+/// Strides are in pixels. It's meant for previews, e.g. a page shown at another scale until it's rendered again:
+/// shrinking by more than half skips source pixels.
+void resizeBilinear(const std::uint32_t* src, int srcWidth, int srcHeight, std::size_t srcStride, std::uint32_t* dst,
+                    int dstWidth, int dstHeight, std::size_t dstStride) noexcept;
+} // namespace yapdf
+
+#endif // YAPDF_PIXEL_HPP_
@@ -0,0 +1,199 @@
+//! Page rendering
+//!
+//! `Renderer` rasterizes pages on `ThreadPool` and keeps the results in a memory cache bounded in bytes, least
+//! recently used pages are evicted first.
+//!
+//! The cache has two tiers. Pages evicted from the hot tier are compressed (see compress.hpp) into a cold tier, which
+//! takes a share of the budget, and decompressed when requested again. Text pages shrink a hundredfold, so many more
+//! pages stay in memory than the budget holds uncompressed. Pages that don't compress well, e.g. photos, are dropped.
+//!
+//! Requests are single-flight: while a page is being rendered, further requests for the same `RenderKey` (another
+//! window on the same document, a visible request catching up with a prefetch) join the in-flight job rather than
+//! rasterizing the page again. The job runs at the highest priority of its waiters.
+//!
+//! Before rasterizing, the job consults the `DiskCache` if it's enabled, and stores newly rasterized pages into it.
+//!
+//! Pages in another `ColorMode` are cached as variants of their own. They're derived from the normal rendering, taken
+//! from the memory or the disk cache when it's there, so switching themes doesn't rasterize again, and drawing a page
+//! doesn't transform it again.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_RENDER_HPP_
+#define YAPDF_RENDER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "document.hpp"
+#include "image.hpp"
+#include "thread_pool.hpp"
+
+namespace yapdf {
+/// The default budget of the memory cache of `Renderer`.
+inline constexpr std::size_t RENDER_CACHE_CAPACITY = std::size_t(256) << 20;
+
+/// The cold tier of the memory cache of `Renderer` is reserved 1 / `RENDER_COLD_SHARE` of its budget.
+inline constexpr std::size_t RENDER_COLD_SHARE = 4;
+
+/// How the colors of a page are transformed after rasterization.
+enum class ColorMode : std::uint8_t {
+    /// As poppler renders it
+    Normal = 0,
+    /// Lightness inverted, hue and saturation kept: white paper turns black, a red link stays red
+    Dark = 1,
+    /// Luminance mapped from dark brown to cream
+    Sepia = 2,
+    /// Luminance mapped from `RenderKey::foreground` to `RenderKey::background`
+    Colormap = 3,
+};
+
+/// The colors of `ColorMode::Sepia`, as 0xRRGGBB.
+inline constexpr std::uint32_t SEPIA_FOREGROUND = 0x5b4636;
+inline constexpr std::uint32_t SEPIA_BACKGROUND = 0xf4ecd8;
+
+/// Identify a rendered page.
+struct RenderKey {
+    /// 0-based page index
+    int page;
+    /// 1.0 renders at 72 DPI
+    double scale;
+    ColorMode mode = ColorMode::Normal;
+    /// The colors of black and white in `ColorMode::Colormap` as 0xRRGGBB, 0 otherwise
+    std::uint32_t foreground = 0;
+    std::uint32_t background = 0;
+
+    /// Return whether `rhs` is the same page in the same colors, at any scale.
+    [[nodiscard]] bool sameColors(const RenderKey& rhs) const noexcept {
+        return page == rhs.page && mode == rhs.mode && foreground == rhs.foreground && background == rhs.background;
+    }
+
+    bool operator==(const RenderKey& rhs) const noexcept {
+        return scale == rhs.scale && sameColors(rhs);
+    }
+
+    bool operator!=(const RenderKey& rhs) const noexcept {
+        return !(*this == rhs);
+    }
+};
+
+struct RenderKeyHash {
+    std::size_t operator()(const RenderKey& key) const noexcept {
+        std::size_t h = std::hash<int>()(key.page) * 31 + std::hash<double>()(key.scale);
+        h = h * 31 + static_cast<std::size_t>(key.mode);
+        return (h * 31 + key.foreground) * 31 + key.background;
+    }
+};
+
+/// Rasterize the 0-based `page` of `doc` at `scale` with poppler, bypassing all caches.
+///
+/// Throw `std::runtime_error` if the page can't be rendered.
+std::shared_ptr<Image> rasterizePage(const Document& doc, int page, double scale);
+
+/// Transform the colors of `img` in place as `key.mode` says.
+void applyColorMode(Image& img, const RenderKey& key) noexcept;
+
+/// Render pages of a `Document`.
+///
+/// It must be owned by a `std::shared_ptr` since in-flight jobs keep it alive.
+class Renderer : public std::enable_shared_from_this<Renderer> {
+public:
+    using Result = std::shared_future<std::shared_ptr<const Image>>;
+
+    /// `capacity` is the budget of the memory cache in bytes, both tiers included.
+    Renderer(std::shared_ptr<Document> doc, std::size_t capacity) noexcept;
+
+    /// Request the page identified by `key`.
+    ///
+    /// The result is ready immediately if it's cached. Otherwise it's shared with the in-flight job of `key`, whose
+    /// priority is raised to `prio`, or a new job is queued with `prio`.
+    ///
+    /// Throw `std::out_of_range` if the page doesn't exist.
+    Result render(const RenderKey& key, Priority prio);
+
+    /// Cache `img` as the page of `key`, as if it had just been rendered.
+    void insert(const RenderKey& key, std::shared_ptr<const Image> img);
+
+    /// Return the page of `key` if it's in the hot tier of the cache, or `nullptr`.
+    ///
+    /// It's called on the main thread, which mustn't wait for a page to be decompressed. `render` thaws pages of the
+    /// cold tier on a worker.
+    std::shared_ptr<const Image> cached(const RenderKey& key);
+
+    /// Return the cached rendering of `key.page` in the colors of `key` whose scale is the closest to `key.scale`
+    /// (by ratio, larger first on ties), with the key it was rendered at. The image is `nullptr` if the page isn't
+    /// cached at any scale.
+    ///
+    /// It stands in for the page while it's rendered at the new scale, e.g. during a zoom. Only the hot tier is
+    /// searched, like `cached`.
+    std::pair<RenderKey, std::shared_ptr<const Image>> nearest(const RenderKey& key);
+
+    /// Return the page of `key` decompressed from the cold tier, or `nullptr`. The page stays cold until it's
+    /// rendered.
+    ///
+    /// It takes a while for a large page, call it on a worker.
+    std::shared_ptr<const Image> thaw(const RenderKey& key);
+
+    /// Return the bytes taken by the hot and the cold tier of the cache.
+    [[nodiscard]] std::pair<std::size_t, std::size_t> usage();
+
+private:
+    struct Flight {
+        Result result;
+        std::shared_ptr<ThreadPool::Job> job;
+        Priority prio;
+    };
+
+    using Entry = std::pair<RenderKey, std::shared_ptr<const Image>>;
+
+    // A compressed page of the cold tier
+    struct Frozen {
+        int width;
+        int height;
+        std::vector<std::uint8_t> data;
+    };
+
+    using ColdEntry = std::pair<RenderKey, std::shared_ptr<const Frozen>>;
+
+    // Rasterize through the cold tier and the disk cache, which holds normal renderings only, then transform the
+    // colors
+    std::shared_ptr<const Image> rasterize(const RenderKey& key);
+
+    // Return the page `frozen` holds, or `nullptr` if it's corrupted
+    static std::shared_ptr<const Image> decompress(const Frozen& frozen);
+
+    // Finish the flight of `key`, caching `img` unless it's `nullptr`
+    void land(const RenderKey& key, std::shared_ptr<const Image> img);
+
+    // Move `img` to the front of the hot tier as the page of `key`, collecting the pages it evicts into `victims`.
+    // Requires `mu_`.
+    void admit(const RenderKey& key, std::shared_ptr<const Image> img, std::vector<Entry>& victims);
+
+    // Compress pages evicted from the hot tier into the cold tier
+    void freeze(std::vector<Entry> victims) noexcept;
+
+    std::shared_ptr<Document> doc_;
+    std::size_t capacity_;
+
+    std::mutex mu_;
+    std::size_t used_ = 0;
+    // Most recently used first
+    std::list<Entry> lru_;
+    std::unordered_map<RenderKey, std::list<Entry>::iterator, RenderKeyHash> cache_;
+    // The cold tier, most recently frozen first. A page is in one tier at most.
+    std::size_t coldUsed_ = 0;
+    std::list<ColdEntry> cold_;
+    std::unordered_map<RenderKey, std::list<ColdEntry>::iterator, RenderKeyHash> coldIndex_;
+    std::unordered_map<RenderKey, Flight, RenderKeyHash> flights_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_RENDER_HPP_
@@ -0,0 +1,141 @@
+//! Full-text search
+//!
+//! `Search` scans the `PageText` of every page on `ThreadPool`, starting from the page the user is on and wrapping
+//! around, so the nearest matches come first. Workers take pages one at a time from a shared cursor, and matches are
+//! streamed to a `Channel` as soon as their page is scanned:
+//!
+//! ``` lisp
+//! (search-matches PAGE (((X0 Y0 X1 Y1) ...) ...))
+//! (search-done TOTAL)
+//! ```
+//!
+//! Every match is a list of boxes in points, one per line it spans. Pages without matches aren't reported.
+//!
+//! Search as you type grows the query one character at a time, and every occurrence of a query is an occurrence of
+//! its prefixes. A `Search` made from the previous one therefore only checks the previous occurrences on the pages
+//! the previous search scanned, at a cost proportional to the number of hits rather than to the size of the document.
+//!
+//! A regular expression search first looks for the longest literal that every match must contain with
+//! `findSubstring`, and only runs the regex engine on the pages that have it.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_SEARCH_HPP_
+#define YAPDF_SEARCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cancellation.hpp"
+#include "channel.hpp"
+#include "document.hpp"
+#include "text.hpp"
+
+namespace yapdf {
+/// A match of a query, as the glyphs [`first`, `last`) of its page.
+struct Match {
+    std::uint32_t first;
+    std::uint32_t last;
+
+    bool operator==(const Match& rhs) const noexcept {
+        return first == rhs.first && last == rhs.last;
+    }
+};
+
+/// Return the byte offsets of all occurrences of `query` in `text`, overlapping ones included.
+///
+/// ASCII case is ignored if `foldCase` is true.
+std::vector<std::uint32_t> occurrences(std::string_view text, std::string_view query, bool foldCase);
+
+/// Return the offsets of `positions` where `text` continues with `query`.
+std::vector<std::uint32_t> refine(std::string_view text, const std::vector<std::uint32_t>& positions,
+                                  std::string_view query, bool foldCase);
+
+/// Return the longest literal that every match of the ECMAScript regular expression `pattern` contains, or an empty
+/// string if none is found.
+std::string requiredLiteral(std::string_view pattern);
+
+/// Return the folding of the text that the ECMAScript regular expression `pattern` is matched against when searching
+/// with `f`.
+///
+/// `std::regex::icase` only ignores ASCII case. A pattern spelling other letters in a case that folding changes, like
+/// "Straße" or "Σα", is matched against the raw text rather than against the case-folded one, which has none of them.
+Folding regexFolding(std::string_view pattern, Folding f);
+
+/// `std::regex` recurses for every character it matches, it's run over at most this many bytes of a line at a time.
+inline constexpr std::size_t REGEX_WINDOW = 4096;
+
+/// Return the matches of `re` in the text of `t` folded with `f`.
+///
+/// The regex engine isn't run at all if the text doesn't contain `literal`, ignoring ASCII case if `re` does. It's
+/// run line by line, so matches don't span lines, and lines longer than `REGEX_WINDOW` in windows that matches don't
+/// span either.
+std::vector<Match> regexMatches(const PageText& t, Folding f, const std::regex& re, std::string_view literal);
+
+/// Convert the occurrences of a query of `length` bytes in the text of `t` folded with `f` to non-overlapping matches.
+std::vector<Match> toMatches(const PageText& t, Folding f, const std::vector<std::uint32_t>& positions,
+                             std::size_t length);
+
+/// Return the non-overlapping occurrences of `query` in `t`, both folded with `f`.
+std::vector<Match> findAll(const PageText& t, std::string_view query, Folding f);
+
+/// Return the boxes covering `m`, one per line.
+std::vector<Box> boxesOf(const PageText& t, const Match& m);
+
+/// A search for a query in a `Document`.
+///
+/// It must be owned by a `std::shared_ptr` since running jobs keep it alive.
+class Search : public std::enable_shared_from_this<Search> {
+public:
+    /// Search for `query` in the page text folded with `folding`.
+    ///
+    /// If `regex` is true, `query` is an ECMAScript regular expression. It's matched ignoring case unless `folding` is
+    /// `Folding::None`, diacritics aren't stripped, see `regexFolding`. Throw `std::regex_error` if `query` isn't a
+    /// valid regular expression.
+    Search(std::shared_ptr<Document> doc, std::string query, Folding folding, bool regex = false);
+
+    /// Search for `query`, which must extend the query of `base`, by refining the occurrences `base` found.
+    Search(std::shared_ptr<const Search> base, std::string query);
+
+    /// Return whether a search for `query` may refine this one. Regular expression searches are never refined.
+    [[nodiscard]] bool refinableTo(std::string_view query, Folding folding, bool regex) const;
+
+    [[nodiscard]] const std::string& query() const noexcept {
+        return query_;
+    }
+
+    /// Scan all pages starting from the 0-based page `from`, streaming the matches to `channel`.
+    ///
+    /// Once `token` is cancelled, the remaining pages are left unscanned and `search-done` isn't reported.
+    void run(std::shared_ptr<Channel> channel, int from, const CancellationToken& token);
+
+private:
+    // Scan `page`, or refine the occurrences of `base_` on it, and report its matches. Return their number.
+    std::size_t scan(int page, Channel& channel);
+
+    // Copy the occurrences on `page` to `out` if it has been scanned
+    bool scanned(int page, std::vector<std::uint32_t>& out) const;
+
+    std::shared_ptr<Document> doc_;
+    std::string query_;
+    Folding folding_;
+    // The folded query, or the folded literal required by every match of `regex_`
+    std::string needle_;
+    std::optional<std::regex> regex_;
+    // Released once all pages are scanned
+    std::shared_ptr<const Search> base_;
+
+    mutable std::mutex mu_;
+    std::vector<std::vector<std::uint32_t>> occurrences_;
+    std::vector<char> scanned_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_SEARCH_HPP_
@@ -0,0 +1,20 @@
+//! Vectorized substring search
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_SUBSTRING_HPP_
+#define YAPDF_SUBSTRING_HPP_
+
+#include <cstddef>
+#include <string_view>
+
+namespace yapdf {
+/// Return the offset of the first occurrence of `needle` in `hay` at or after `from`, or `std::string_view::npos`.
+///
+/// ASCII case is ignored if `foldCase` is true. With SSE2, 16 candidate offsets are tested at once by comparing the
+/// first and last bytes of `needle`, and only the offsets where both match are compared in full, so text without the
+/// needle is skipped at close to memory bandwidth.
+std::size_t findSubstring(std::string_view hay, std::string_view needle, bool foldCase, std::size_t from = 0) noexcept;
+} // namespace yapdf
+
+#endif // YAPDF_SUBSTRING_HPP_
@@ -0,0 +1,109 @@
+//! Page text
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_TEXT_HPP_
+#define YAPDF_TEXT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace poppler {
+class page;
+} // namespace poppler
+
+namespace yapdf {
+/// A rectangle in points from the top-left corner of a page.
+struct Box {
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+};
+
+/// How text is normalized for search, see `foldCodePoint`.
+enum class Folding : std::uint8_t {
+    /// Exact
+    None = 0,
+    /// Case-folded, with ligatures and compatibility forms expanded
+    Case = 1,
+    /// As `Case`, with diacritics stripped as well
+    Diacritics = 2,
+};
+
+/// A normalized copy of the text of a page.
+///
+/// Glyph `i` of the page folds to the bytes of `text` from `offsets[i]` up to the next glyph or separator. Words are
+/// separated like in `PageText::text`.
+struct FoldedText {
+    std::string text;
+    std::vector<std::uint32_t> offsets;
+};
+
+/// The text of a page with the bounding box of every glyph.
+///
+/// Glyphs are stored as a structure of arrays, so a scan over one attribute (e.g. the text for search, the boxes for
+/// hit testing) touches nothing else. Glyph `i` is the code point starting at byte `offsets[i]` of `text`, its box
+/// spans `(x0[i], y0[i])` to `(x1[i], y1[i])` in points from the top-left corner of the page.
+///
+/// Words are separated by a space or a newline in `text`, which don't belong to any glyph.
+///
+/// The folded copies for search are made on the first search with their `Folding`, most pages are never searched.
+/// `text` and `offsets` mustn't change after that.
+struct PageText {
+    /// UTF-8 text
+    std::string text;
+    std::vector<std::uint32_t> offsets;
+    std::vector<float> x0;
+    std::vector<float> y0;
+    std::vector<float> x1;
+    std::vector<float> y1;
+
+    /// Extract the text of `page`.
+    static PageText extract(const poppler::page& page);
+
+    /// Return the text searched with `f`, and the offsets of the glyphs in it.
+    ///
+    /// It's safe to call from several threads at once.
+    [[nodiscard]] std::pair<std::string_view, const std::vector<std::uint32_t>&> view(Folding f) const;
+
+    /// Return the number of glyphs.
+    [[nodiscard]] std::size_t glyphs() const noexcept {
+        return offsets.size();
+    }
+
+    /// Return the bytes taken by the text, counting the folded copies that searches may make of it.
+    [[nodiscard]] std::size_t bytes() const noexcept {
+        // A folded copy is about as large as `text` and `offsets`
+        return 3 * (text.size() + offsets.size() * sizeof(std::uint32_t)) + 4 * x0.size() * sizeof(float);
+    }
+
+    /// Return the box of glyph `i`.
+    [[nodiscard]] Box box(std::size_t i) const noexcept {
+        return Box{x0[i], y0[i], x1[i], y1[i]};
+    }
+
+private:
+    struct Folds {
+        std::once_flag caseOnce;
+        std::once_flag bareOnce;
+        // Folded with `Folding::Case`
+        FoldedText folded;
+        // Folded with `Folding::Diacritics`
+        FoldedText bare;
+    };
+
+    // Fill `out` from `text`, stripping diacritics if `strip` is true
+    void fold(FoldedText& out, bool strip) const;
+
+    std::unique_ptr<Folds> folds_ = std::make_unique<Folds>();
+};
+} // namespace yapdf
+
+#endif // YAPDF_TEXT_HPP_
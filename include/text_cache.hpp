@@ -0,0 +1,78 @@
+//! Page text cache
+//!
+//! Search, selection, copy and hovering all need the text of a page again, along with the glyph index and the links
+//! derived from it. A `TextCache` keeps them for the most recently used pages within a budget in bytes, rather than for
+//! every page ever extracted, which adds up on documents of thousands of pages.
+//!
+//! The glyph index and the links of a page are evicted with its text, and are only attached to the text they were
+//! derived from.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_TEXT_CACHE_HPP_
+#define YAPDF_TEXT_CACHE_HPP_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "text.hpp"
+
+namespace yapdf {
+class GlyphIndex;
+class LinkMap;
+
+/// The default budget of `TextCache`.
+inline constexpr std::size_t TEXT_CACHE_CAPACITY = std::size_t(64) << 20;
+
+/// The text of the most recently used pages of a document, and what's derived from it.
+///
+/// It's safe to use from several threads at once.
+class TextCache {
+public:
+    /// What's cached of a page. Derived entries are `nullptr` until attached.
+    struct Entry {
+        std::shared_ptr<const PageText> text;
+        std::shared_ptr<const GlyphIndex> glyphs;
+        std::shared_ptr<const LinkMap> links;
+    };
+
+    /// Cache the text of `pages` pages up to `capacity` bytes (see `PageText::bytes`), and at least the newest one.
+    TextCache(int pages, std::size_t capacity);
+
+    /// Return what's cached of `page`, its `text` is `nullptr` if it isn't cached.
+    Entry find(int page);
+
+    /// Cache `text` as the text of `page`, unless another thread did meanwhile. Return the cached text.
+    std::shared_ptr<const PageText> insert(int page, std::shared_ptr<const PageText> text);
+
+    /// Attach `glyphs` to `page` if its cached text is `text`, unless another thread did meanwhile. Return the
+    /// attached index, or `glyphs` if the text isn't cached anymore.
+    std::shared_ptr<const GlyphIndex> insert(int page, const std::shared_ptr<const PageText>& text,
+                                             std::shared_ptr<const GlyphIndex> glyphs);
+
+    /// Attach `links` like `glyphs`.
+    std::shared_ptr<const LinkMap> insert(int page, const std::shared_ptr<const PageText>& text,
+                                          std::shared_ptr<const LinkMap> links);
+
+    /// Return the bytes taken by the cached text.
+    [[nodiscard]] std::size_t usage();
+
+private:
+    // Mark `page`, which must be cached, as the most recently used. Requires `mu_`.
+    void touch(int page);
+
+    std::mutex mu_;
+    std::size_t capacity_;
+    std::size_t used_ = 0;
+    std::vector<Entry> entries_;
+    // Cached pages, most recently used first
+    std::list<int> lru_;
+    // The position of every page in `lru_`, or `lru_.end()`
+    std::vector<std::list<int>::iterator> pos_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_TEXT_CACHE_HPP_
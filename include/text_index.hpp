@@ -0,0 +1,108 @@
+//! Persistent inverted text index
+//!
+//! A `TextIndex` maps every word of a document to its postings, the page, word position and first glyph of each
+//! occurrence, so word and phrase queries are answered without looking at the page text at all.
+//!
+//! It's built in the background the first time a document is opened and stored in the index directory under the
+//! content hash of the file. Later opens map the stored index read-only instead of extracting the text again. A
+//! modified file has another hash and gets a new index.
+//!
+//! Words are maximal runs of ASCII letters and digits and non-ASCII characters, ASCII case is folded. Chinese and
+//! Japanese have no spaces between words, so runs of CJK characters are indexed as overlapping bigrams instead: every
+//! character is a term along with the next one, and the last one of a run alone. A phrase of CJK characters is then
+//! found like a phrase of words.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_TEXT_INDEX_HPP_
+#define YAPDF_TEXT_INDEX_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cancellation.hpp"
+#include "document.hpp"
+#include "mapped_file.hpp"
+
+namespace yapdf {
+class TextIndex {
+public:
+    /// An occurrence of a word.
+    struct Posting {
+        /// 0-based page index
+        std::uint32_t page;
+        /// The index of the word among the words of the page
+        std::uint32_t position;
+        /// The first glyph of the word in `PageText`
+        std::uint32_t glyph;
+    };
+
+    /// The postings of the folded words of a range of pages, sorted by page and position.
+    using Postings = std::unordered_map<std::string, std::vector<Posting>>;
+
+    /// Return the default index directory, `$XDG_CACHE_HOME/yapdf/index` or `~/.cache/yapdf/index`.
+    static std::string defaultDirectory();
+
+    /// Return the directory where documents are indexed on open, empty if indexing is disabled.
+    static std::string directory();
+
+    /// Set the directory where documents are indexed on open, empty disables indexing.
+    static void directory(std::string dir);
+
+    /// Call `f` with every word or CJK bigram of `text` and its byte offset.
+    static void tokenize(std::string_view text, const std::function<void(std::string_view, std::size_t)>& f);
+
+    /// Open the index of `doc` in `dir` on `ThreadPool`, building it if it doesn't exist yet, and attach it to `doc`.
+    ///
+    /// Once `token` is cancelled, a build is abandoned. Errors leave `doc` without index.
+    static void load(std::shared_ptr<Document> doc, const std::string& dir, const CancellationToken& token);
+
+    /// Merge the postings of consecutive ranges of pages and store them at `path` as the index of the file whose
+    /// content hash is `doc`.
+    ///
+    /// Throw `std::system_error` or `std::runtime_error` if it can't be written.
+    static void write(const std::string& path, std::uint64_t doc, const std::vector<Postings>& chunks);
+
+    /// Map the index stored at `path`.
+    ///
+    /// Throw `std::system_error` if it can't be read, or `std::runtime_error` if it's corrupted or doesn't belong to
+    /// the file whose content hash is `doc`.
+    TextIndex(const std::string& path, std::uint64_t doc);
+
+    /// Return the number of distinct words.
+    [[nodiscard]] std::size_t terms() const noexcept;
+
+    /// Return the occurrences of the phrase `query`, the postings of its first word, in page order.
+    [[nodiscard]] std::vector<Posting> find(std::string_view query) const;
+
+private:
+    struct Header;
+    struct Term;
+
+    // Collect the postings of pages [`first`, `last`)
+    static Postings collect(const Document& doc, int first, int last, const CancellationToken& token);
+
+    // Return the string of `t`
+    std::string_view text(const Term& t) const noexcept;
+
+    // Return the first term not less than `prefix`
+    const Term* prefixed(std::string_view prefix) const noexcept;
+
+    // Return the postings of the folded `word`
+    std::pair<const Posting*, const Posting*> postings(std::string_view word) const noexcept;
+
+    MappedFile file_;
+    const Header* header_;
+    const Term* terms_;
+    const Posting* postings_;
+    const char* strings_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_TEXT_INDEX_HPP_
@@ -0,0 +1,100 @@
+//! A fixed-size pool of worker threads
+//!
+//! Work which would block Emacs for a noticeable time (rendering, text extraction, exporting) is submitted to the pool
+//! and the caller gets a `std::future` for the result. Exceptions thrown by a job are stored in its future.
+//!
+//! Jobs are scheduled by `Priority`, FIFO within the same priority. The priority of a queued job can be raised later,
+//! e.g. when a prefetched page becomes visible.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_THREAD_POOL_HPP_
+#define YAPDF_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace yapdf {
+/// Scheduling priority of a job, higher priorities run first.
+enum class Priority {
+    /// Speculative work the user may never look at, e.g. prefetching and thumbnails
+    Low = 0,
+    /// Work the user is waiting for, but not on screen
+    Normal = 1,
+    /// Work the user is looking at, e.g. rendering visible pages
+    High = 2,
+};
+
+class ThreadPool {
+public:
+    /// A queued job.
+    struct Job;
+
+    /// Return the pool shared by the whole module, sized to the number of hardware threads.
+    static ThreadPool& getInstance() noexcept;
+
+    /// Spawn `n` worker threads. At least one worker is spawned.
+    explicit ThreadPool(std::size_t n);
+
+    /// Discard the pending jobs and join all workers.
+    ///
+    /// Futures of discarded jobs report `std::future_errc::broken_promise`.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Return the number of worker threads.
+    [[nodiscard]] std::size_t size() const noexcept {
+        return workers_.size();
+    }
+
+    /// Return the index in [0, `size()`) of the calling thread if it's a worker of this pool, -1 otherwise.
+    ///
+    /// It allows jobs to use per-worker resources without locking.
+    [[nodiscard]] int worker() const noexcept;
+
+    /// Queue `f` for execution on a worker thread.
+    template <typename F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& f, Priority prio = Priority::Normal) {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+
+        // `std::function` requires a copyable target, `std::packaged_task` isn't
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> fut = task->get_future();
+        post([task] { (*task)(); }, prio);
+        return fut;
+    }
+
+    /// Queue `f` for execution on a worker thread, returning a handle to the job for `raise`.
+    ///
+    /// Unlike `submit`, the result of `f` is discarded and `f` must not throw.
+    std::shared_ptr<Job> post(std::function<void()> f, Priority prio = Priority::Normal);
+
+    /// Raise the priority of a job to `prio` if it's still queued with a lower priority.
+    void raise(const std::shared_ptr<Job>& job, Priority prio);
+
+private:
+    static constexpr std::size_t PRIORITIES = 3;
+
+    void run(int index);
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    // One FIFO per priority. A raised job is queued again at its new priority, the stale entry is skipped when popped.
+    std::deque<std::shared_ptr<Job>> jobs_[PRIORITIES];
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_THREAD_POOL_HPP_
@@ -0,0 +1,88 @@
+//! Page thumbnails
+//!
+//! Thumbnails are rendered at twice their size on `ThreadPool` at `Priority::Low`, so they never delay the pages on
+//! screen, and downsampled with `boxHalve`. They're packed into square cells of atlas sheets `THUMBNAIL_SHEET_SIZE`
+//! pixels wide rather than allocated one by one, so the thumbnails of a 1000-page document take a handful of
+//! allocations.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_THUMBNAILS_HPP_
+#define YAPDF_THUMBNAILS_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "cancellation.hpp"
+#include "channel.hpp"
+#include "document.hpp"
+#include "image.hpp"
+
+namespace yapdf {
+/// The width and maximum height of an atlas sheet in pixels.
+inline constexpr int THUMBNAIL_SHEET_SIZE = 2048;
+
+/// Valid thumbnail sizes.
+inline constexpr int THUMBNAIL_MIN_SIZE = 16;
+inline constexpr int THUMBNAIL_MAX_SIZE = 512;
+
+/// The thumbnails of a `Document`.
+///
+/// It must be owned by a `std::shared_ptr` since running jobs keep it alive.
+class Thumbnails : public std::enable_shared_from_this<Thumbnails> {
+public:
+    /// Thumbnails fit in a `size` by `size` box, keeping the aspect ratio of their page.
+    ///
+    /// Throw `std::out_of_range` if `size` is less than `THUMBNAIL_MIN_SIZE` or greater than `THUMBNAIL_MAX_SIZE`.
+    Thumbnails(std::shared_ptr<Document> doc, int size);
+
+    /// Return `size`, or throw `std::out_of_range` if it isn't a valid thumbnail size.
+    static int checkSize(int size);
+
+    [[nodiscard]] int size() const noexcept {
+        return size_;
+    }
+
+    /// Render the thumbnails of all pages on `ThreadPool`, reporting each page to `channel` once it's done.
+    ///
+    /// Every page is reported as a line `(thumbnail PAGE WIDTH HEIGHT)`, pages already done immediately, pages that
+    /// fail to render as `(thumbnail PAGE nil nil)`. `(thumbnails-done)` follows the last page. Once `token` is
+    /// cancelled, the remaining pages are dropped without report.
+    void generate(std::shared_ptr<Channel> channel, const CancellationToken& token);
+
+    /// Return a copy of the thumbnail of the 0-based `page`, or `nullptr` if it isn't done yet.
+    ///
+    /// Throw `std::out_of_range` if the page doesn't exist.
+    [[nodiscard]] std::shared_ptr<Image> get(int page) const;
+
+private:
+    struct Cell {
+        bool ready = false;
+        int width = 0;
+        int height = 0;
+    };
+
+    // Render the thumbnail of `page` into its cell unless it's ready. Return a copy of the cell, which isn't ready if
+    // the page can't be rendered.
+    Cell make(int page);
+
+    // Return the top-left pixel of the cell of `page`. Requires `mu_`.
+    std::uint32_t* origin(int page) const noexcept;
+
+    std::shared_ptr<Document> doc_;
+    int size_;
+    // Cells per row of a sheet, and per sheet
+    int columns_;
+    int cellsPerSheet_;
+
+    // Guards the cells and the pixels of the sheets
+    mutable std::mutex mu_;
+    std::vector<Cell> cells_;
+    // Allocated on first use
+    std::vector<std::unique_ptr<Image>> sheets_;
+};
+} // namespace yapdf
+
+#endif // YAPDF_THUMBNAILS_HPP_
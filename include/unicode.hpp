@@ -0,0 +1,32 @@
+//! Unicode helpers for text search
+//!
+//! Search folds page text and queries alike, so a query matches regardless of case, ligatures (a typeset "ﬁ" is one
+//! glyph) and, optionally, diacritics. Folding covers Latin, Greek and Cyrillic case, the Latin ligatures, common
+//! compatibility forms (fullwidth ASCII, no-break and typographic spaces, typographic quotes and hyphens), and
+//! diacritics of Latin-1 and Latin Extended-A letters and combining marks.
+//!
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef YAPDF_UNICODE_HPP_
+#define YAPDF_UNICODE_HPP_
+
+#include <string>
+#include <string_view>
+
+namespace yapdf {
+/// Append `c` to `s` as UTF-8.
+void appendUtf8(std::string& s, char32_t c);
+
+/// Decode the code point at `p` and advance `p` past it. An invalid byte decodes as itself.
+char32_t decodeUtf8(const char*& p, const char* end) noexcept;
+
+/// Append the folded form of `c` to `s` as UTF-8, stripping its diacritics if `strip` is true.
+///
+/// The folded form may be empty (e.g. a soft hyphen) or longer than one code point (e.g. "ﬃ" folds to "ffi").
+void foldCodePoint(char32_t c, bool strip, std::string& s);
+
+/// Fold every code point of the UTF-8 `s` with `foldCodePoint`.
+std::string foldString(std::string_view s, bool strip);
+} // namespace yapdf
+
+#endif // YAPDF_UNICODE_HPP_
@@ -2,6 +2,183 @@
 //!
 //! SPDX-License-Identifier: GPL-2.0-or-later
 
+#ifndef YAPDF_VIEWER_HPP_
+#define YAPDF_VIEWER_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "cancellation.hpp"
+#include "debounce.hpp"
+#include "document.hpp"
+#include "layout.hpp"
+#include "mipmap.hpp"
+#include "outline.hpp"
+#include "render.hpp"
+#include "search.hpp"
+#include "thumbnails.hpp"
+
 namespace yapdf {
+/// How long the scale must stay the same during a zoom before the page is rendered again.
+inline constexpr std::chrono::milliseconds ZOOM_SETTLE_DELAY{150};
+
+/// The state behind a `yapdf--open`ed user pointer.
+///
+/// The `Document` is shared with jobs running on `ThreadPool`, so it may outlive the `Viewer`.
+class Viewer {
+public:
+    explicit Viewer(std::shared_ptr<Document> doc)
+        : doc_(std::move(doc)), renderer_(std::make_shared<Renderer>(doc_, RENDER_CACHE_CAPACITY)),
+          mipmaps_(std::make_shared<MipmapCache>(MIPMAP_CACHE_CAPACITY)), zoom_(ZOOM_SETTLE_DELAY) {}
+
+    ~Viewer() {
+        thumbnailing_.cancel();
+        searching_.cancel();
+        indexing_.cancel();
+        scanning_.cancel();
+        cropping_.cancel();
+    }
+
+    Viewer(const Viewer&) = delete;
+    Viewer& operator=(const Viewer&) = delete;
+
+    [[nodiscard]] const std::shared_ptr<Document>& document() const noexcept {
+        return doc_;
+    }
+
+    [[nodiscard]] Renderer& renderer() const noexcept {
+        return *renderer_;
+    }
+
+    [[nodiscard]] const std::shared_ptr<Renderer>& sharedRenderer() const noexcept {
+        return renderer_;
+    }
+
+    /// Return the pyramids of the pages zoomed recently.
+    [[nodiscard]] const std::shared_ptr<MipmapCache>& mipmaps() const noexcept {
+        return mipmaps_;
+    }
+
+    /// Return the debouncer of the renders of zoomed pages.
+    [[nodiscard]] Debouncer& zoom() noexcept {
+        return zoom_;
+    }
+
+    /// Return the key of `page` at `scale` in the colors of the viewer.
+    [[nodiscard]] RenderKey key(int page, double scale) const noexcept {
+        return {page, scale, mode_, foreground_, background_};
+    }
+
+    /// Draw pages in `mode`, with `foreground` and `background` as 0xRRGGBB for `ColorMode::Colormap`.
+    void colors(ColorMode mode, std::uint32_t foreground, std::uint32_t background) noexcept {
+        mode_ = mode;
+        foreground_ = mode == ColorMode::Colormap ? foreground : 0;
+        background_ = mode == ColorMode::Colormap ? background : 0;
+    }
+
+    /// Return the last thumbnails made, or `nullptr`.
+    [[nodiscard]] const std::shared_ptr<Thumbnails>& thumbnails() const noexcept {
+        return thumbnails_;
+    }
+
+    /// Return the thumbnails of `size`. Thumbnails of another size are dropped.
+    [[nodiscard]] const std::shared_ptr<Thumbnails>& thumbnails(int size) {
+        if (!thumbnails_ || thumbnails_->size() != size) {
+            thumbnails_ = std::make_shared<Thumbnails>(doc_, size);
+        }
+        return thumbnails_;
+    }
+
+    /// Cancel the running `Thumbnails::generate`, and return the token of the next one.
+    [[nodiscard]] const CancellationToken& restartThumbnailing() {
+        thumbnailing_.cancel();
+        thumbnailing_ = CancellationToken();
+        return thumbnailing_;
+    }
+
+    /// Return the last search, or `nullptr`.
+    [[nodiscard]] const std::shared_ptr<Search>& search() const noexcept {
+        return search_;
+    }
+
+    /// Cancel the running search, and return the token of `search`, which replaces it.
+    [[nodiscard]] const CancellationToken& restartSearch(std::shared_ptr<Search> search) {
+        searching_.cancel();
+        searching_ = CancellationToken();
+        search_ = std::move(search);
+        return searching_;
+    }
+
+    /// Return the token of the text index build of the document, cancelled with the viewer.
+    [[nodiscard]] const CancellationToken& indexing() const noexcept {
+        return indexing_;
+    }
+
+    /// Return the token of the page size scan of the document, cancelled with the viewer.
+    [[nodiscard]] const CancellationToken& scanning() const noexcept {
+        return scanning_;
+    }
+
+    /// Return the layout pages are shown in, of their content boxes if cropping.
+    [[nodiscard]] std::shared_ptr<const Layout> layout() const noexcept {
+        std::shared_ptr<const Layout> cropped = crop_ ? doc_->contentLayout() : nullptr;
+        return cropped ? cropped : doc_->layout();
+    }
+
+    /// Crop pages to their content if `enable`. The content layout is scanned on first use, starting from `page`.
+    ///
+    /// Disabling cropping stops a scan still running. Pages cropped so far stay cached in the document, so enabling
+    /// it again only crops the others.
+    void crop(bool enable, int page) {
+        crop_ = enable;
+        if (!enable) {
+            cropping_.cancel();
+            cropping_ = CancellationToken();
+            const std::shared_ptr<const Layout> layout = doc_->contentLayout();
+            cropScanned_ = layout && layout->exact();
+        } else if (!cropScanned_) {
+            Layout::scanContent(doc_, page, cropping_);
+            cropScanned_ = true;
+        }
+    }
+
+    /// Return the outline of the document, or `nullptr` until it's read.
+    [[nodiscard]] const std::shared_ptr<const Outline>& outline() const noexcept {
+        return outline_;
+    }
+
+    /// Keep the outline once read.
+    void outline(std::shared_ptr<const Outline> outline) noexcept {
+        outline_ = std::move(outline);
+    }
+
+    /// Cancel the running search.
+    void cancelSearch() const noexcept {
+        searching_.cancel();
+    }
+
+private:
+    std::shared_ptr<Document> doc_;
+    std::shared_ptr<Renderer> renderer_;
+    std::shared_ptr<Thumbnails> thumbnails_;
+    CancellationToken thumbnailing_;
+    std::shared_ptr<Search> search_;
+    CancellationToken searching_;
+    CancellationToken indexing_;
+    CancellationToken scanning_;
+    CancellationToken cropping_;
+    bool crop_ = false;
+    // Whether the content layout is scanned or being scanned
+    bool cropScanned_ = false;
+    std::shared_ptr<const Outline> outline_;
+    std::shared_ptr<MipmapCache> mipmaps_;
+    Debouncer zoom_;
+    ColorMode mode_ = ColorMode::Normal;
+    std::uint32_t foreground_ = 0;
+    std::uint32_t background_ = 0;
+};
+} // namespace yapdf
 
-}
+#endif // YAPDF_VIEWER_HPP_
@@ -31,6 +31,40 @@
 (declare-function yapdf--new "libyapdf")
 (declare-function yapdf--hide "libyapdf")
 (declare-function yapdf--show "libyapdf")
+(declare-function yapdf--open "libyapdf")
+(declare-function yapdf--pages "libyapdf")
+(declare-function yapdf--text "libyapdf")
+(declare-function yapdf--page-text "libyapdf")
+(declare-function yapdf--glyph-at "libyapdf")
+(declare-function yapdf--word-at "libyapdf")
+(declare-function yapdf--select "libyapdf")
+(declare-function yapdf--link-at "libyapdf")
+(declare-function yapdf--links "libyapdf")
+(declare-function yapdf--outline "libyapdf")
+(declare-function yapdf--export-text "libyapdf")
+(declare-function yapdf--render "libyapdf")
+(declare-function yapdf--prefetch "libyapdf")
+(declare-function yapdf--zoom "libyapdf")
+(declare-function yapdf--set-colors "libyapdf")
+(declare-function yapdf--layout-extent "libyapdf")
+(declare-function yapdf--layout-exact-p "libyapdf")
+(declare-function yapdf--set-crop "libyapdf")
+(declare-function yapdf--content-box "libyapdf")
+(declare-function yapdf--page-offset "libyapdf")
+(declare-function yapdf--page-at "libyapdf")
+(declare-function yapdf--visible-pages "libyapdf")
+(declare-function yapdf--thumbnails "libyapdf")
+(declare-function yapdf--thumbnail "libyapdf")
+(declare-function yapdf--search "libyapdf")
+(declare-function yapdf--cancel-search "libyapdf")
+(declare-function yapdf--enable-disk-cache "libyapdf")
+(declare-function yapdf--disable-disk-cache "libyapdf")
+(declare-function yapdf--enable-text-index "libyapdf")
+(declare-function yapdf--disable-text-index "libyapdf")
+(declare-function yapdf--indexed-p "libyapdf")
+(declare-function yapdf--index-search "libyapdf")
+(declare-function yapdf--huge-pages "libyapdf")
+(declare-function yapdf--trim-memory "libyapdf")
 
 (defvar yapdf--buffers nil)
 (defvar-local yapdf--id nil)
@@ -0,0 +1,170 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "buffer_pool.hpp"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace {
+// Smaller buffers of the pool are rounded up to a multiple of this
+constexpr std::size_t GRANULE = std::size_t(64) << 10;
+
+// Map `size` bytes, or return `nullptr`. Buffers of a huge page or more start on a huge page boundary, so that every
+// bit of them can be backed by huge pages: `mmap` only aligns to small pages.
+std::uint8_t* mapBuffer(std::size_t size) noexcept {
+    const std::size_t slack = size >= yapdf::BUFFER_POOL_HUGE_PAGE ? yapdf::BUFFER_POOL_HUGE_PAGE : 0;
+    void* p = ::mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    if (slack == 0) {
+        return static_cast<std::uint8_t*>(p);
+    }
+
+    // Unmap the slack around the aligned range
+    const auto start = reinterpret_cast<std::uintptr_t>(p);
+    const std::uintptr_t aligned = (start + slack - 1) / slack * slack;
+    if (aligned > start) {
+        ::munmap(p, aligned - start);
+    }
+    if (const std::size_t tail = slack - (aligned - start); tail > 0) {
+        ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+    }
+    return reinterpret_cast<std::uint8_t*>(aligned);
+}
+} // namespace
+
+namespace yapdf {
+BufferPool& BufferPool::getInstance() noexcept {
+    static BufferPool* pool = new BufferPool(BUFFER_POOL_CAPACITY);
+    return *pool;
+}
+
+BufferPool::~BufferPool() {
+    trim();
+}
+
+std::size_t BufferPool::sizeClass(std::size_t bytes) noexcept {
+    if (bytes < BUFFER_POOL_MIN_SIZE) {
+        return bytes;
+    }
+
+    const std::size_t step = bytes >= BUFFER_POOL_HUGE_PAGE ? BUFFER_POOL_HUGE_PAGE : GRANULE;
+    return (bytes + step - 1) / step * step;
+}
+
+BufferPool::Buffer BufferPool::acquire(std::size_t bytes) {
+    const std::size_t size = sizeClass(bytes);
+    if (bytes < BUFFER_POOL_MIN_SIZE) {
+        return Buffer(new std::uint8_t[size], Release(this, bytes));
+    }
+
+    std::uint8_t* p = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (auto it = free_.find(size); it != free_.end() && !it->second.empty()) {
+            p = it->second.back();
+            it->second.pop_back();
+            idle_ -= size;
+        }
+    }
+
+    if (!p) {
+        p = mapBuffer(size);
+    }
+    if (!p) {
+        // Idle buffers of other classes may be what's missing
+        trim();
+        p = mapBuffer(size);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+    }
+
+#ifdef MADV_HUGEPAGE
+    // Only a hint, the kernel may lack transparent huge pages. Idle buffers are advised again when reused, they may
+    // have been mapped before huge pages were enabled.
+    if (hugePages_.load(std::memory_order_relaxed) && size >= BUFFER_POOL_HUGE_PAGE) {
+        ::madvise(p, size, MADV_HUGEPAGE);
+    }
+#endif
+    return Buffer(p, Release(this, bytes));
+}
+
+void BufferPool::trim() noexcept {
+    std::map<std::size_t, std::vector<std::uint8_t*>> free;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        free.swap(free_);
+        idle_ = 0;
+    }
+
+    for (const auto& [size, buffers] : free) {
+        for (std::uint8_t* p : buffers) {
+            ::munmap(p, size);
+        }
+    }
+}
+
+std::size_t BufferPool::idle() const noexcept {
+    std::lock_guard<std::mutex> lock(mu_);
+    return idle_;
+}
+
+void BufferPool::release(std::uint8_t* p, std::size_t bytes) noexcept {
+    if (!p) {
+        return;
+    }
+
+    const std::size_t size = sizeClass(bytes);
+    if (bytes < BUFFER_POOL_MIN_SIZE) {
+        delete[] p;
+        return;
+    }
+
+#if defined(MADV_FREE)
+    // The pages stay mapped, and are only reclaimed if memory runs low. The contents are lost then, which doesn't
+    // matter since buffers are handed out uninitialized. Kernels before 4.5 reject it.
+    if (::madvise(p, size, MADV_FREE) != 0) {
+        ::madvise(p, size, MADV_DONTNEED);
+    }
+#elif defined(MADV_DONTNEED)
+    // Reclaimed right away, reusing the buffer faults its pages in again
+    ::madvise(p, size, MADV_DONTNEED);
+#endif
+
+    // Buffers of other classes make room first, the scale they were rendered at is likely gone
+    std::vector<std::pair<std::uint8_t*, std::size_t>> victims;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        for (auto it = free_.begin(); it != free_.end() && idle_ + size > capacity_;) {
+            if (it->first == size) {
+                ++it;
+                continue;
+            }
+
+            while (!it->second.empty() && idle_ + size > capacity_) {
+                victims.emplace_back(it->second.back(), it->first);
+                it->second.pop_back();
+                idle_ -= it->first;
+            }
+            it = it->second.empty() ? free_.erase(it) : std::next(it);
+        }
+
+        if (idle_ + size <= capacity_) {
+            free_[size].push_back(p);
+            idle_ += size;
+        } else {
+            victims.emplace_back(p, size);
+        }
+    }
+
+    for (const auto& [victim, length] : victims) {
+        ::munmap(victim, length);
+    }
+}
+} // namespace yapdf
@@ -0,0 +1,27 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "channel.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace yapdf {
+Channel::~Channel() {
+    ::close(fd_);
+}
+
+bool Channel::write(std::string_view msg) noexcept {
+    std::lock_guard<std::mutex> lock(mu_);
+    while (!broken_ && !msg.empty()) {
+        const ssize_t n = ::write(fd_, msg.data(), msg.size());
+        if (n >= 0) {
+            msg.remove_prefix(static_cast<std::size_t>(n));
+        } else if (errno != EINTR) {
+            // Most likely EPIPE after the process is deleted
+            broken_ = true;
+        }
+    }
+    return !broken_;
+}
+} // namespace yapdf
@@ -0,0 +1,88 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "compress.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Runs of at least this length are worth a repeat chunk
+constexpr std::size_t MIN_RUN = 3;
+constexpr std::size_t MAX_CHUNK = 128;
+
+void put(std::vector<std::uint8_t>& out, const std::uint32_t* px, std::size_t n) {
+    const std::size_t at = out.size();
+    out.resize(at + n * 4);
+    std::memcpy(out.data() + at, px, n * 4);
+}
+
+// Return the length of the run of equal pixels starting at `px`, at most `MAX_CHUNK`
+std::size_t runLength(const std::uint32_t* px, const std::uint32_t* end) noexcept {
+    const std::uint32_t* p = px + 1;
+    const std::uint32_t* limit = std::min(end, px + MAX_CHUNK);
+    while (p < limit && *p == *px) {
+        ++p;
+    }
+    return p - px;
+}
+} // namespace
+
+namespace yapdf {
+void compressPixels(const std::uint32_t* px, std::size_t n, std::vector<std::uint8_t>& out) {
+    const std::uint32_t* const end = px + n;
+    const std::uint32_t* literal = px;
+
+    const auto flush = [&](const std::uint32_t* upto) {
+        while (literal < upto) {
+            const std::size_t k = std::min<std::size_t>(upto - literal, MAX_CHUNK);
+            out.push_back(static_cast<std::uint8_t>(k - 1));
+            put(out, literal, k);
+            literal += k;
+        }
+    };
+
+    while (px < end) {
+        const std::size_t run = runLength(px, end);
+        if (run < MIN_RUN) {
+            px += run;
+            continue;
+        }
+
+        flush(px);
+        out.push_back(static_cast<std::uint8_t>(run + 127));
+        put(out, px, 1);
+        px += run;
+        literal = px;
+    }
+    flush(end);
+}
+
+bool decompressPixels(const std::uint8_t* src, std::size_t len, std::uint32_t* px, std::size_t n) noexcept {
+    const std::uint8_t* const end = src + len;
+    std::uint32_t* const last = px + n;
+
+    while (src < end) {
+        const std::uint8_t c = *src++;
+        if (c < 128) {
+            const std::size_t k = c + 1;
+            if (static_cast<std::size_t>(end - src) < k * 4 || static_cast<std::size_t>(last - px) < k) {
+                return false;
+            }
+            std::memcpy(px, src, k * 4);
+            src += k * 4;
+            px += k;
+        } else {
+            const std::size_t k = c - 127;
+            if (end - src < 4 || static_cast<std::size_t>(last - px) < k) {
+                return false;
+            }
+
+            std::uint32_t v;
+            std::memcpy(&v, src, 4);
+            src += 4;
+            px = std::fill_n(px, k, v);
+        }
+    }
+    return px == last;
+}
+} // namespace yapdf
@@ -0,0 +1,36 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "crop.hpp"
+
+#include "pixel.hpp"
+
+#include <algorithm>
+
+namespace yapdf {
+Box contentBox(const Image& img, double scale) noexcept {
+    const double width = img.width() / scale;
+    const double height = img.height() / scale;
+
+    int x0 = img.width();
+    int x1 = 0;
+    int y0 = img.height();
+    int y1 = 0;
+    for (int y = 0; y < img.height(); ++y) {
+        const auto [first, last] = foregroundSpan(img.row(y), img.width(), CROP_BACKGROUND, CROP_TOLERANCE);
+        if (first < last) {
+            x0 = std::min(x0, first);
+            x1 = std::max(x1, last);
+            y0 = std::min(y0, y);
+            y1 = y + 1;
+        }
+    }
+    if (x0 >= x1) {
+        return Box{0, 0, static_cast<float>(width), static_cast<float>(height)};
+    }
+
+    return Box{static_cast<float>(std::max(0.0, x0 / scale - CROP_PADDING)),
+               static_cast<float>(std::max(0.0, y0 / scale - CROP_PADDING)),
+               static_cast<float>(std::min(width, x1 / scale + CROP_PADDING)),
+               static_cast<float>(std::min(height, y1 / scale + CROP_PADDING))};
+}
+} // namespace yapdf
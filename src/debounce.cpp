@@ -0,0 +1,76 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "debounce.hpp"
+
+#include <signal.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace yapdf {
+struct Debouncer::State {
+    std::mutex mu;
+    std::condition_variable cv;
+    std::function<void()> pending;
+    std::chrono::steady_clock::time_point deadline;
+    bool started = false;
+    bool stopped = false;
+
+    void run() {
+        // Calls may write to `Channel`s like jobs of `ThreadPool`
+        sigset_t pipe;
+        sigemptyset(&pipe);
+        sigaddset(&pipe, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipe, nullptr);
+
+        std::unique_lock<std::mutex> lock(mu);
+        while (!stopped) {
+            if (!pending) {
+                cv.wait(lock);
+                continue;
+            }
+            if (std::chrono::steady_clock::now() < deadline) {
+                cv.wait_until(lock, deadline);
+                continue;
+            }
+
+            std::function<void()> f = std::move(pending);
+            pending = nullptr;
+            lock.unlock();
+            try {
+                f();
+            } catch (...) {
+                // Nobody to report to
+            }
+            lock.lock();
+        }
+    }
+};
+
+Debouncer::Debouncer(std::chrono::milliseconds delay) noexcept : delay_(delay), state_(std::make_shared<State>()) {}
+
+Debouncer::~Debouncer() {
+    std::lock_guard<std::mutex> lock(state_->mu);
+    state_->pending = nullptr;
+    state_->stopped = true;
+    state_->cv.notify_one();
+}
+
+void Debouncer::call(std::function<void()> f) {
+    std::lock_guard<std::mutex> lock(state_->mu);
+    state_->pending = std::move(f);
+    state_->deadline = std::chrono::steady_clock::now() + delay_;
+    if (!state_->started) {
+        std::thread([state = state_] { state->run(); }).detach();
+        state_->started = true;
+    }
+    state_->cv.notify_one();
+}
+
+void Debouncer::cancel() noexcept {
+    std::lock_guard<std::mutex> lock(state_->mu);
+    state_->pending = nullptr;
+}
+} // namespace yapdf
@@ -0,0 +1,336 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "disk_cache.hpp"
+
+#include "compress.hpp"
+#include "hash.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr char INDEX_MAGIC[8] = {'Y', 'A', 'P', 'D', 'F', 'I', 'D', 'X'};
+constexpr std::uint32_t INDEX_VERSION = 2;
+constexpr std::uint32_t INDEX_SLOTS = 16384;
+
+constexpr std::uint32_t PAGE_MAGIC = 0x46445059; // "YPDF"
+// Guard against allocating absurd images from corrupted pages
+constexpr std::uint32_t PAGE_MAX_DIMENSION = 1 << 15;
+
+enum SlotState : std::uint8_t {
+    Empty = 0,
+    Used = 1,
+};
+
+// Hold `flock` on the index for the current scope
+class FileLock {
+public:
+    explicit FileLock(int fd) noexcept : fd_(fd) {
+        while (::flock(fd_, LOCK_EX) == -1 && errno == EINTR) {
+        }
+    }
+
+    ~FileLock() {
+        ::flock(fd_, LOCK_UN);
+    }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    int fd_;
+};
+
+std::uint64_t scaleBits(double scale) noexcept {
+    std::uint64_t bits;
+    std::memcpy(&bits, &scale, sizeof(bits));
+    return bits;
+}
+
+// Return the preferred slot of a key. Collisions are resolved by linear probing.
+std::uint32_t home(std::uint64_t doc, std::uint64_t scale, std::int32_t page, std::uint8_t mode) noexcept {
+    const std::uint64_t k[] = {doc, scale, static_cast<std::uint64_t>(page), mode};
+    return static_cast<std::uint32_t>(yapdf::hash64(k, sizeof(k)) % INDEX_SLOTS);
+}
+
+std::shared_ptr<yapdf::DiskCache> global_cache;
+} // namespace
+
+namespace yapdf {
+struct DiskCache::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slots;
+    // The total size of the pages
+    std::uint64_t bytes;
+    // The number of used slots
+    std::uint32_t used;
+    std::uint32_t reserved;
+    // A logical clock for LRU, bumped on every access
+    std::uint64_t tick;
+};
+
+struct DiskCache::Slot {
+    std::uint64_t doc;
+    std::uint64_t scale;
+    std::int32_t page;
+    std::uint8_t mode;
+    std::uint8_t state;
+    std::uint16_t reserved;
+    std::uint32_t bytes;
+    std::uint32_t reserved2;
+    std::uint64_t tick;
+
+    bool matches(std::uint64_t d, const RenderKey& key) const noexcept {
+        return doc == d && page == key.page && scale == scaleBits(key.scale) &&
+               mode == static_cast<std::uint8_t>(key.mode);
+    }
+};
+
+std::string DiskCache::defaultDirectory() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && xdg[0] == '/') {
+        return std::string(xdg) + "/yapdf";
+    }
+
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : "") + "/.cache/yapdf";
+}
+
+std::shared_ptr<DiskCache> DiskCache::global() noexcept {
+    return std::atomic_load(&global_cache);
+}
+
+void DiskCache::global(std::shared_ptr<DiskCache> cache) noexcept {
+    std::atomic_store(&global_cache, std::move(cache));
+}
+
+DiskCache::DiskCache(const std::string& dir, std::size_t capacity) : dir_(dir), capacity_(capacity) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        throw std::system_error(ec, "mkdir " + dir_);
+    }
+
+    const std::string index = dir_ + "/index";
+    fd_ = ::open(index.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        throw std::system_error(errno, std::generic_category(), "open " + index);
+    }
+
+    const std::size_t size = sizeof(Header) + sizeof(Slot) * INDEX_SLOTS;
+    {
+        FileLock lock(fd_);
+        struct stat st;
+        const bool ok = ::fstat(fd_, &st) == 0 &&
+                        (static_cast<std::size_t>(st.st_size) == size || ::ftruncate(fd_, size) == 0);
+        if (!ok) {
+            const int err = errno;
+            ::close(fd_);
+            throw std::system_error(err, std::generic_category(), "resize " + index);
+        }
+
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            const int err = errno;
+            ::close(fd_);
+            throw std::system_error(err, std::generic_category(), "mmap " + index);
+        }
+        header_ = static_cast<Header*>(p);
+        slots_ = reinterpret_cast<Slot*>(header_ + 1);
+
+        // A new or incompatible index starts empty, orphaned pages are overwritten as they're stored again
+        if (std::memcmp(header_->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+            header_->version != INDEX_VERSION || header_->slots != INDEX_SLOTS) {
+            std::memset(p, 0, size);
+            std::memcpy(header_->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+            header_->version = INDEX_VERSION;
+            header_->slots = INDEX_SLOTS;
+        }
+    }
+}
+
+DiskCache::~DiskCache() {
+    ::munmap(header_, sizeof(Header) + sizeof(Slot) * INDEX_SLOTS);
+    ::close(fd_);
+}
+
+std::shared_ptr<Image> DiskCache::load(std::uint64_t doc, const RenderKey& key) noexcept {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> guard(mu_);
+        FileLock lock(fd_);
+        Slot* slot = find(doc, key);
+        if (!slot || slot->state != Used) {
+            return nullptr;
+        }
+
+        slot->tick = ++header_->tick;
+        path = pathOf(*slot);
+    }
+
+    // Read and decompress without holding the locks
+    try {
+        std::ifstream in(path, std::ios::binary);
+        std::uint32_t head[3];
+        if (in.read(reinterpret_cast<char*>(head), sizeof(head)) && head[0] == PAGE_MAGIC &&
+            head[1] <= PAGE_MAX_DIMENSION && head[2] <= PAGE_MAX_DIMENSION) {
+            const std::vector<std::uint8_t> body((std::istreambuf_iterator<char>(in)),
+                                                 std::istreambuf_iterator<char>());
+            auto img = std::make_shared<Image>(static_cast<int>(head[1]), static_cast<int>(head[2]));
+
+            // Rows are compressed back to back
+            const std::size_t n = static_cast<std::size_t>(img->width()) * img->height();
+            if (decompressPixels(body.data(), body.size(), img->row(0), n)) {
+                return img;
+            }
+        }
+    } catch (const std::exception&) {
+        // fall through
+    }
+
+    // The page is missing or corrupted
+    std::lock_guard<std::mutex> guard(mu_);
+    FileLock lock(fd_);
+    if (Slot* slot = find(doc, key); slot && slot->state == Used) {
+        erase(slot);
+    }
+    return nullptr;
+}
+
+void DiskCache::store(std::uint64_t doc, const RenderKey& key, const Image& img) noexcept {
+    try {
+        const std::uint32_t head[3] = {PAGE_MAGIC, static_cast<std::uint32_t>(img.width()),
+                                       static_cast<std::uint32_t>(img.height())};
+        std::vector<std::uint8_t> buf(reinterpret_cast<const std::uint8_t*>(head),
+                                      reinterpret_cast<const std::uint8_t*>(head + 3));
+        for (int y = 0; y < img.height(); ++y) {
+            compressPixels(img.row(y), img.width(), buf);
+        }
+        if (buf.size() > capacity_) {
+            return;
+        }
+
+        // Write to a private file first, so readers never see a partial page
+        char tmp[64];
+        std::snprintf(tmp, sizeof(tmp), "/tmp.%ld.%zu", static_cast<long>(::getpid()),
+                      std::hash<std::thread::id>()(std::this_thread::get_id()));
+        const std::string tmpPath = dir_ + tmp;
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.write(reinterpret_cast<const char*>(buf.data()), buf.size())) {
+                std::remove(tmpPath.c_str());
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(mu_);
+        FileLock lock(fd_);
+        if (Slot* slot = find(doc, key); slot && slot->state == Used) {
+            // Stored by another thread or process meanwhile
+            std::remove(tmpPath.c_str());
+            return;
+        }
+
+        evict(buf.size());
+        Slot* slot = find(doc, key);
+        if (!slot) {
+            std::remove(tmpPath.c_str());
+            return;
+        }
+
+        slot->doc = doc;
+        slot->scale = scaleBits(key.scale);
+        slot->page = key.page;
+        slot->mode = static_cast<std::uint8_t>(key.mode);
+        slot->bytes = static_cast<std::uint32_t>(buf.size());
+        slot->tick = ++header_->tick;
+        if (std::rename(tmpPath.c_str(), pathOf(*slot).c_str()) != 0) {
+            std::remove(tmpPath.c_str());
+            return;
+        }
+
+        slot->state = Used;
+        header_->bytes += buf.size();
+        ++header_->used;
+    } catch (const std::exception&) {
+        // The cache is best effort
+    }
+}
+
+DiskCache::Slot* DiskCache::find(std::uint64_t doc, const RenderKey& key) noexcept {
+    const std::uint32_t h = home(doc, scaleBits(key.scale), key.page, static_cast<std::uint8_t>(key.mode));
+    for (std::uint32_t i = 0; i < INDEX_SLOTS; ++i) {
+        Slot& slot = slots_[(h + i) % INDEX_SLOTS];
+        if (slot.state == Empty || slot.matches(doc, key)) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void DiskCache::erase(Slot* slot) noexcept {
+    std::remove(pathOf(*slot).c_str());
+    header_->bytes -= std::min<std::uint64_t>(header_->bytes, slot->bytes);
+    header_->used -= header_->used > 0;
+
+    // Shift the following entries of the probe sequence back instead of leaving a tombstone, so a lookup still ends
+    // at the first empty slot
+    std::uint32_t i = static_cast<std::uint32_t>(slot - slots_);
+    for (std::uint32_t j = (i + 1) % INDEX_SLOTS; slots_[j].state == Used; j = (j + 1) % INDEX_SLOTS) {
+        const std::uint32_t k = home(slots_[j].doc, slots_[j].scale, slots_[j].page, slots_[j].mode);
+
+        // Move `j` into the hole at `i` unless its home lies cyclically in (i, j]
+        const bool stays = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+        if (!stays) {
+            slots_[i] = slots_[j];
+            i = j;
+        }
+    }
+    slots_[i].state = Empty;
+}
+
+void DiskCache::evict(std::size_t bytes) noexcept {
+    // Keep a quarter of the slots free, so probing stays short. The totals are kept in the header, so the slots are
+    // only scanned when something must go.
+    while (header_->bytes + bytes > capacity_ || header_->used >= INDEX_SLOTS / 4 * 3) {
+        Slot* oldest = nullptr;
+        for (std::uint32_t i = 0; i < INDEX_SLOTS; ++i) {
+            if (slots_[i].state == Used && (!oldest || slots_[i].tick < oldest->tick)) {
+                oldest = &slots_[i];
+            }
+        }
+        if (!oldest) {
+            // The totals are off, e.g. after a crash mid-update
+            header_->bytes = 0;
+            header_->used = 0;
+            break;
+        }
+
+        erase(oldest);
+    }
+}
+
+std::string DiskCache::pathOf(const Slot& slot) const {
+    char name[96];
+    std::snprintf(name, sizeof(name), "/%016" PRIx64 "-%" PRId32 "-%016" PRIx64 "-%u.page", slot.doc, slot.page,
+                  slot.scale, static_cast<unsigned>(slot.mode));
+    return dir_ + name;
+}
+} // namespace yapdf
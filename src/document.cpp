@@ -0,0 +1,187 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "document.hpp"
+
+#include "crop.hpp"
+#include "glyph_index.hpp"
+#include "hash.hpp"
+#include "layout.hpp"
+#include "links.hpp"
+#include "render.hpp"
+#include "text_index.hpp"
+
+#include <poppler/cpp/poppler-page.h>
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+std::unique_ptr<poppler::document> load(const yapdf::MappedFile& data, const std::string& path) {
+    if (data.size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+        throw std::runtime_error("File too large: " + path);
+    }
+
+    std::unique_ptr<poppler::document> doc(
+        poppler::document::load_from_raw_data(data.data(), static_cast<int>(data.size())));
+    if (!doc) {
+        throw std::runtime_error("Failed to load " + path);
+    }
+
+    if (doc->is_locked()) {
+        throw std::runtime_error("Document is locked: " + path);
+    }
+    return doc;
+}
+} // namespace
+
+namespace yapdf {
+Document::Document(const std::string& path)
+    : path_(path), file_(path), doc_(load(file_, path)), instances_(ThreadPool::getInstance().size()),
+      pages_(doc_->pages()), texts_(pages_, TEXT_CACHE_CAPACITY), contents_(pages_) {}
+
+std::uint64_t Document::hash() const {
+    std::call_once(hashed_, [this] {
+        checkFile();
+        hash_ = hash64(file_.data(), file_.size());
+    });
+    return hash_;
+}
+
+PageSize Document::size(int page) const {
+    return use([page](const poppler::document& doc) {
+        const std::unique_ptr<poppler::page> p(doc.create_page(page));
+        if (!p) {
+            throw std::runtime_error("Failed to load page " + std::to_string(page));
+        }
+
+        const poppler::rectf box = p->page_rect();
+        const poppler::page::orientation_enum o = p->orientation();
+        if (o == poppler::page::landscape || o == poppler::page::seascape) {
+            return PageSize{box.height(), box.width()};
+        }
+        return PageSize{box.width(), box.height()};
+    });
+}
+
+void Document::checkFile() const {
+    if (file_.changed()) {
+        throw std::runtime_error("File changed on disk: " + path_);
+    }
+}
+
+const poppler::document& Document::instance(int i) const {
+    std::unique_ptr<poppler::document>& doc = instances_[i];
+    if (!doc) {
+        doc = load(file_, path_);
+    }
+    return *doc;
+}
+
+std::shared_ptr<const PageText> Document::text(int page) const {
+    if (page < 0 || page >= pages_) {
+        throw std::out_of_range("No such page: " + std::to_string(page));
+    }
+    if (std::shared_ptr<const PageText> t = texts_.find(page).text) {
+        return t;
+    }
+
+    // Extract without holding the lock, a concurrent extraction of the same page is wasted but harmless
+    auto t = std::make_shared<const PageText>(use([page](const poppler::document& doc) {
+        const std::unique_ptr<poppler::page> p(doc.create_page(page));
+        if (!p) {
+            throw std::runtime_error("Failed to load page " + std::to_string(page));
+        }
+        return PageText::extract(*p);
+    }));
+    return texts_.insert(page, std::move(t));
+}
+
+std::shared_ptr<const GlyphIndex> Document::glyphs(int page) const {
+    const std::shared_ptr<const PageText> t = text(page);
+    if (std::shared_ptr<const GlyphIndex> idx = texts_.find(page).glyphs) {
+        return idx;
+    }
+    return texts_.insert(page, t, std::make_shared<const GlyphIndex>(t));
+}
+
+std::shared_ptr<const LinkMap> Document::links(int page) const {
+    const std::shared_ptr<const PageText> t = text(page);
+    if (std::shared_ptr<const LinkMap> links = texts_.find(page).links) {
+        return links;
+    }
+    return texts_.insert(page, t, std::make_shared<const LinkMap>(LinkMap::extract(*t)));
+}
+
+Box Document::content(int page) const {
+    if (page < 0 || page >= pages_) {
+        throw std::out_of_range("No such page: " + std::to_string(page));
+    }
+
+    std::shared_future<Box> fut;
+    std::promise<Box> promise;
+    {
+        std::lock_guard<std::mutex> lock(contentMu_);
+        fut = contents_[page];
+        if (!fut.valid()) {
+            contents_[page] = promise.get_future().share();
+        }
+    }
+    // Cropped already, or being cropped by another thread
+    if (fut.valid()) {
+        return fut.get();
+    }
+
+    try {
+        const Box box = contentBox(*rasterizePage(*this, page, CROP_SCALE), CROP_SCALE);
+        promise.set_value(box);
+        return box;
+    } catch (...) {
+        // Not cached, the next call tries again
+        {
+            std::lock_guard<std::mutex> lock(contentMu_);
+            contents_[page] = std::shared_future<Box>();
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+std::shared_ptr<const TextIndex> Document::index() const noexcept {
+    return std::atomic_load(&index_);
+}
+
+void Document::index(std::shared_ptr<const TextIndex> idx) const noexcept {
+    std::atomic_store(&index_, std::move(idx));
+}
+
+std::shared_ptr<const Layout> Document::layout() const noexcept {
+    return std::atomic_load(&layout_);
+}
+
+void Document::layout(std::shared_ptr<const Layout> layout) const noexcept {
+    std::atomic_store(&layout_, std::move(layout));
+}
+
+std::shared_ptr<const Layout> Document::contentLayout() const noexcept {
+    return std::atomic_load(&contentLayout_);
+}
+
+void Document::contentLayout(std::shared_ptr<const Layout> layout) const noexcept {
+    std::atomic_store(&contentLayout_, std::move(layout));
+}
+
+std::string Document::text(int first, int last, const CancellationToken& token) const {
+    std::string s;
+    for (int i = first; i < last && !token.cancelled(); ++i) {
+        if (i > first) {
+            s.push_back('\f');
+        }
+        s += text(i)->text;
+    }
+    return s;
+}
+} // namespace yapdf
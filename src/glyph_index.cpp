@@ -0,0 +1,164 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "glyph_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Glyphs per cell the grid is sized for, and its largest dimension
+constexpr std::size_t GLYPHS_PER_CELL = 4;
+constexpr int MAX_CELLS = 512;
+
+// Return the squared distance from (`x`, `y`) to `box`, 0 if it's inside
+float distance2(const yapdf::Box& box, float x, float y) noexcept {
+    const float dx = std::max({box.x0 - x, 0.0f, x - box.x1});
+    const float dy = std::max({box.y0 - y, 0.0f, y - box.y1});
+    return dx * dx + dy * dy;
+}
+
+bool intersects(const yapdf::Box& a, const yapdf::Box& b) noexcept {
+    return a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1;
+}
+} // namespace
+
+namespace yapdf {
+GlyphIndex::GlyphIndex(std::shared_ptr<const PageText> text) : text_(std::move(text)) {
+    const PageText& t = *text_;
+    const std::size_t n = t.glyphs();
+    for (std::size_t i = 0; i < n; ++i) {
+        width_ = std::max(width_, t.x1[i]);
+        height_ = std::max(height_, t.y1[i]);
+    }
+
+    // Roughly square cells
+    if (width_ > 0 && height_ > 0) {
+        const double cells = static_cast<double>(std::max<std::size_t>(1, n / GLYPHS_PER_CELL));
+        columns_ = std::clamp(static_cast<int>(std::lround(std::sqrt(cells * width_ / height_))), 1, MAX_CELLS);
+        rows_ = std::clamp(static_cast<int>(std::ceil(cells / columns_)), 1, MAX_CELLS);
+    }
+
+    // Count the glyphs of every cell, then place them, which keeps each cell in glyph order
+    const auto each = [&](auto&& f) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const int c1 = column(t.x1[i]);
+            const int r1 = row(t.y1[i]);
+            for (int r = row(t.y0[i]); r <= r1; ++r) {
+                for (int c = column(t.x0[i]); c <= c1; ++c) {
+                    f(static_cast<std::size_t>(r) * columns_ + c, static_cast<std::uint32_t>(i));
+                }
+            }
+        }
+    };
+
+    cells_.assign(static_cast<std::size_t>(columns_) * rows_ + 1, 0);
+    each([this](std::size_t cell, std::uint32_t) { ++cells_[cell + 1]; });
+    for (std::size_t c = 1; c < cells_.size(); ++c) {
+        cells_[c] += cells_[c - 1];
+    }
+
+    std::vector<std::uint32_t> next(cells_.begin(), cells_.end() - 1);
+    glyphs_.resize(cells_.back());
+    each([&](std::size_t cell, std::uint32_t i) { glyphs_[next[cell]++] = i; });
+
+    // Glyphs of a word aren't separated in the text
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::uint32_t offset = t.offsets[i];
+        if (i == 0 || t.text[offset - 1] == ' ' || t.text[offset - 1] == '\n') {
+            words_.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+}
+
+int GlyphIndex::at(float x, float y) const noexcept {
+    const std::size_t cell = static_cast<std::size_t>(row(y)) * columns_ + column(x);
+    for (std::uint32_t k = cells_[cell]; k < cells_[cell + 1]; ++k) {
+        const std::uint32_t i = glyphs_[k];
+        if (distance2(text_->box(i), x, y) == 0) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int GlyphIndex::nearest(float x, float y) const noexcept {
+    if (glyphs_.empty()) {
+        return -1;
+    }
+
+    // Scan rings of cells around the point. Glyphs first found in ring k + 1 are at least k cells away.
+    const int c0 = column(x);
+    const int r0 = row(y);
+    const float cell = std::min(width_ / columns_, height_ / rows_);
+    int best = -1;
+    float bestDistance = std::numeric_limits<float>::infinity();
+    for (int k = 0; k < std::max(columns_, rows_); ++k) {
+        if (best >= 0 && bestDistance <= (k - 1) * cell * ((k - 1) * cell)) {
+            break;
+        }
+
+        for (int r = std::max(0, r0 - k); r <= std::min(rows_ - 1, r0 + k); ++r) {
+            // Only the border of the ring, the inside was scanned already
+            const int step = r == r0 - k || r == r0 + k ? 1 : 2 * k;
+            for (int c = c0 - k; c <= c0 + k; c += std::max(step, 1)) {
+                if (c < 0 || c >= columns_) {
+                    continue;
+                }
+
+                const std::size_t i = static_cast<std::size_t>(r) * columns_ + c;
+                for (std::uint32_t g = cells_[i]; g < cells_[i + 1]; ++g) {
+                    const float d = distance2(text_->box(glyphs_[g]), x, y);
+                    if (d < bestDistance || (d == bestDistance && static_cast<int>(glyphs_[g]) < best)) {
+                        best = static_cast<int>(glyphs_[g]);
+                        bestDistance = d;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+std::vector<std::uint32_t> GlyphIndex::within(const Box& box) const {
+    const Box b{std::min(box.x0, box.x1), std::min(box.y0, box.y1), std::max(box.x0, box.x1),
+                std::max(box.y0, box.y1)};
+    std::vector<std::uint32_t> out;
+    for (int r = row(b.y0); r <= row(b.y1); ++r) {
+        for (int c = column(b.x0); c <= column(b.x1); ++c) {
+            const std::size_t cell = static_cast<std::size_t>(r) * columns_ + c;
+            for (std::uint32_t k = cells_[cell]; k < cells_[cell + 1]; ++k) {
+                if (intersects(text_->box(glyphs_[k]), b)) {
+                    out.push_back(glyphs_[k]);
+                }
+            }
+        }
+    }
+
+    // A glyph spanning several cells is found in each
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+std::pair<std::uint32_t, std::uint32_t> GlyphIndex::word(std::uint32_t i) const noexcept {
+    const auto it = std::upper_bound(words_.begin(), words_.end(), i);
+    const std::uint32_t last = it == words_.end() ? static_cast<std::uint32_t>(text_->glyphs()) : *it;
+    return {*(it - 1), last};
+}
+
+int GlyphIndex::column(float x) const noexcept {
+    // Negated, so that NaN is clamped too
+    if (!(x > 0)) {
+        return 0;
+    }
+    return static_cast<int>(std::min<double>(columns_ - 1, static_cast<double>(x) / width_ * columns_));
+}
+
+int GlyphIndex::row(float y) const noexcept {
+    if (!(y > 0)) {
+        return 0;
+    }
+    return static_cast<int>(std::min<double>(rows_ - 1, static_cast<double>(y) / height_ * rows_));
+}
+} // namespace yapdf
@@ -0,0 +1,100 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "hash.hpp"
+
+#include <cstring>
+
+namespace {
+constexpr std::uint64_t PRIME1 = 0x9e3779b185ebca87ULL;
+constexpr std::uint64_t PRIME2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr std::uint64_t PRIME3 = 0x165667b19e3779f9ULL;
+constexpr std::uint64_t PRIME4 = 0x85ebca77c2b2ae63ULL;
+constexpr std::uint64_t PRIME5 = 0x27d4eb2f165667c5ULL;
+
+inline std::uint64_t rotl(std::uint64_t x, int r) noexcept {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Unaligned little-endian loads, XXH64 is defined on little-endian input
+inline std::uint64_t read64(const unsigned char* p) noexcept {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline std::uint32_t read32(const unsigned char* p) noexcept {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t input) noexcept {
+    return rotl(acc + input * PRIME2, 31) * PRIME1;
+}
+
+inline std::uint64_t merge(std::uint64_t acc, std::uint64_t val) noexcept {
+    return (acc ^ round(0, val)) * PRIME1 + PRIME4;
+}
+} // namespace
+
+namespace yapdf {
+std::uint64_t hash64(const void* data, std::size_t len, std::uint64_t seed) noexcept {
+    const auto* p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + len;
+
+    std::uint64_t h;
+    if (len >= 32) {
+        std::uint64_t v1 = seed + PRIME1 + PRIME2;
+        std::uint64_t v2 = seed + PRIME2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - PRIME1;
+
+        // four independent lanes keep the multipliers busy
+        for (const unsigned char* limit = end - 32; p <= limit; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    } else {
+        h = seed + PRIME5;
+    }
+
+    h += len;
+
+    for (; end - p >= 8; p += 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+
+    if (end - p >= 4) {
+        h ^= read32(p) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+
+    for (; p < end; ++p) {
+        h ^= *p * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+} // namespace yapdf
@@ -0,0 +1,209 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "layout.hpp"
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+// Pages read per job, so a refined layout isn't copied for every page
+constexpr int SCAN_CHUNK = 256;
+// Pages cropped per job, each is rendered
+constexpr int CROP_CHUNK = 16;
+
+// The layout refined by the jobs of a scan
+struct Scan {
+    explicit Scan(yapdf::Layout l, int n) : layout(std::move(l)), pending(n) {}
+
+    std::mutex mu;
+    yapdf::Layout layout;
+    int pending;
+    // For `scanContent`, the layout the pages not cropped yet are taken from, and which pages are cropped
+    std::shared_ptr<const yapdf::Layout> base;
+    std::vector<bool> cropped;
+};
+
+// Return the order of `chunks` chunks starting from `start`, alternating between the chunks after and before it
+std::vector<int> outwards(int start, int chunks) {
+    std::vector<int> order;
+    order.reserve(chunks);
+    for (int d = 0; static_cast<int>(order.size()) < chunks; ++d) {
+        if (start + d < chunks) {
+            order.push_back(start + d);
+        }
+        if (d > 0 && start - d >= 0) {
+            order.push_back(start - d);
+        }
+    }
+    return order;
+}
+} // namespace
+
+namespace yapdf {
+void Layout::scan(std::shared_ptr<Document> doc, const CancellationToken& token) {
+    // Most documents have pages of one size
+    const int pages = doc->pages();
+    PageSize guess{0, 0};
+    try {
+        guess = pages > 0 ? doc->size(0) : guess;
+    } catch (const std::exception&) {
+        // Refined by the scan
+    }
+
+    const int chunks = (pages - 1 + SCAN_CHUNK - 1) / SCAN_CHUNK;
+    auto scan = std::make_shared<Scan>(Layout(std::vector<PageSize>(pages, guess)), chunks);
+    scan->layout.exact_ = pages <= 1;
+    doc->layout(std::make_shared<const Layout>(scan->layout));
+
+    for (int first = 1; first < pages; first += SCAN_CHUNK) {
+        const int last = std::min(pages, first + SCAN_CHUNK);
+        ThreadPool::getInstance().post(
+            [doc, token, scan, guess, chunks, first, last] {
+                std::vector<PageSize> sizes;
+                sizes.reserve(last - first);
+                for (int i = first; i < last && !token.cancelled(); ++i) {
+                    try {
+                        sizes.push_back(doc->size(i));
+                    } catch (const std::exception&) {
+                        sizes.push_back(guess);
+                    }
+                }
+                if (token.cancelled()) {
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(scan->mu);
+                scan->layout.update(first, sizes);
+                scan->layout.exact_ = --scan->pending == 0;
+                // Publishing copies the whole layout, do it after 1, 2, 4, ... chunks rather than after each
+                if (const int done = chunks - scan->pending; scan->layout.exact_ || (done & (done - 1)) == 0) {
+                    doc->layout(std::make_shared<const Layout>(scan->layout));
+                }
+            },
+            Priority::Low);
+    }
+}
+
+void Layout::scanContent(std::shared_ptr<Document> doc, int from, const CancellationToken& token) {
+    // Pages not cropped yet keep their full size, which may still be estimated by `scan`
+    const std::shared_ptr<const Layout> base = doc->layout();
+    const int pages = base->pages();
+    const int chunks = (pages + CROP_CHUNK - 1) / CROP_CHUNK;
+    auto scan = std::make_shared<Scan>(*base, chunks);
+    scan->layout.exact_ = pages == 0;
+    scan->base = base;
+    scan->cropped.resize(pages);
+    doc->contentLayout(std::make_shared<const Layout>(scan->layout));
+
+    // Jobs of the same priority run in order, so the pages around `from` are cropped first
+    const int start = std::clamp(from, 0, std::max(0, pages - 1)) / CROP_CHUNK;
+    for (const int chunk : outwards(start, chunks)) {
+        const int first = chunk * CROP_CHUNK;
+        const int last = std::min(pages, first + CROP_CHUNK);
+        ThreadPool::getInstance().post(
+            [doc, token, scan, pages, first, last] {
+                std::vector<PageSize> sizes;
+                sizes.reserve(last - first);
+                for (int i = first; i < last && !token.cancelled(); ++i) {
+                    try {
+                        const Box box = doc->content(i);
+                        sizes.push_back(PageSize{box.x1 - box.x0, box.y1 - box.y0});
+                    } catch (const std::exception&) {
+                        // Read the size rather than trust the base layout, it may be an estimate
+                        try {
+                            sizes.push_back(doc->size(i));
+                        } catch (const std::exception&) {
+                            sizes.push_back(scan->base->size(i));
+                        }
+                    }
+                }
+                if (token.cancelled()) {
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(scan->mu);
+                // Once `scan` is done, the pages not cropped yet take their exact sizes
+                if (!scan->base->exact()) {
+                    if (std::shared_ptr<const Layout> layout = doc->layout(); layout->exact()) {
+                        std::vector<PageSize> rebased;
+                        rebased.reserve(pages);
+                        for (int i = 0; i < pages; ++i) {
+                            rebased.push_back(scan->cropped[i] ? scan->layout.size(i) : layout->size(i));
+                        }
+                        scan->layout.update(0, rebased);
+                        scan->base = std::move(layout);
+                    }
+                }
+
+                std::fill(scan->cropped.begin() + first, scan->cropped.begin() + last, true);
+                scan->layout.update(first, sizes);
+                scan->layout.exact_ = --scan->pending == 0;
+                doc->contentLayout(std::make_shared<const Layout>(scan->layout));
+            },
+            Priority::Low);
+    }
+}
+
+Layout::Layout(const std::vector<PageSize>& sizes) : tops_(sizes.size() + 1, 0.0), widths_(sizes.size(), 0.0) {
+    update(0, sizes);
+}
+
+std::pair<double, double> Layout::extent(double scale, double gap) const noexcept {
+    const int n = pages();
+    return {width_ * scale, n == 0 ? 0.0 : tops_[n] * scale + (n - 1) * gap};
+}
+
+int Layout::pageAt(double y, double scale, double gap) const noexcept {
+    // The last page whose top is at or above `y`. Offsets grow with the page index, so bisect on it.
+    int lo = 0;
+    int hi = pages();
+    while (hi - lo > 1) {
+        const int mid = lo + (hi - lo) / 2;
+        if (offset(mid, scale, gap) <= y) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return pages() == 0 ? -1 : lo;
+}
+
+std::pair<int, int> Layout::visible(double top, double height, double scale, double gap) const noexcept {
+    if (pages() == 0 || height <= 0) {
+        return {0, 0};
+    }
+
+    int first = pageAt(top, scale, gap);
+    // Skip the page above if only the gap below it is visible
+    if (offset(first, scale, gap) + (tops_[first + 1] - tops_[first]) * scale <= top) {
+        ++first;
+    }
+    const int last = pageAt(top + height, scale, gap);
+    const bool shown = offset(last, scale, gap) < top + height;
+    return {first, std::max(first, shown ? last + 1 : last)};
+}
+
+void Layout::update(int first, const std::vector<PageSize>& sizes) {
+    const int n = pages();
+    const int last = std::min(n, first + static_cast<int>(sizes.size()));
+
+    // The pages below keep their heights, but move
+    std::vector<double> heights;
+    heights.reserve(n - first);
+    for (int i = first; i < n; ++i) {
+        heights.push_back(i < last ? sizes[i - first].height : tops_[i + 1] - tops_[i]);
+    }
+    for (int i = first; i < last; ++i) {
+        widths_[i] = sizes[i - first].width;
+    }
+    for (int i = first; i < n; ++i) {
+        tops_[i + 1] = tops_[i] + heights[i - first];
+    }
+    width_ = widths_.empty() ? 0.0 : *std::max_element(widths_.begin(), widths_.end());
+}
+} // namespace yapdf
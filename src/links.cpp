@@ -0,0 +1,103 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "links.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace {
+// Return the length of the URL prefix `text` starts with, or 0
+std::size_t schemeLength(std::string_view text) noexcept {
+    static constexpr std::string_view SCHEMES[] = {"http://", "https://", "ftp://", "file://", "mailto:", "www."};
+    for (std::string_view s : SCHEMES) {
+        if (text.size() > s.size() && text.compare(0, s.size(), s) == 0) {
+            return s.size();
+        }
+    }
+    return 0;
+}
+
+// Printable ASCII except spaces and delimiters that never appear unescaped in a URL
+bool isUrlByte(char c) noexcept {
+    return c > ' ' && c < 0x7f && std::strchr("\"<>\\^`{|}", c) == nullptr;
+}
+
+// Trailing punctuation usually belongs to the sentence, and a closing bracket to the text around the URL unless the
+// URL opens it
+std::size_t trimUrl(std::string_view url) noexcept {
+    std::size_t n = url.size();
+    while (n > 0) {
+        const char c = url[n - 1];
+        if (std::strchr(".,;:!?'", c) != nullptr) {
+            --n;
+        } else if (c == ')' && std::count(url.begin(), url.begin() + n, '(') <
+                                   std::count(url.begin(), url.begin() + n, ')')) {
+            --n;
+        } else if (c == ']' && url.substr(0, n).find('[') == std::string_view::npos) {
+            --n;
+        } else {
+            break;
+        }
+    }
+    return n;
+}
+
+// Return true if the URL at `pos` starts a word
+bool startsWord(std::string_view text, std::size_t pos) noexcept {
+    if (pos == 0) {
+        return true;
+    }
+    const unsigned char c = text[pos - 1];
+    return !(c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'));
+}
+} // namespace
+
+namespace yapdf {
+LinkMap LinkMap::extract(const PageText& text) {
+    const std::string_view s = text.text;
+    const auto glyphAt = [&](std::size_t pos) {
+        return static_cast<std::uint32_t>(std::lower_bound(text.offsets.begin(), text.offsets.end(), pos) -
+                                          text.offsets.begin());
+    };
+
+    std::vector<Link> links;
+    std::size_t pos = 0;
+    while (pos < s.size()) {
+        const std::size_t scheme = startsWord(s, pos) ? schemeLength(s.substr(pos)) : 0;
+        if (scheme == 0) {
+            ++pos;
+            continue;
+        }
+
+        std::size_t end = pos;
+        for (; end < s.size() && isUrlByte(s[end]); ++end) {
+        }
+        const std::size_t length = trimUrl(s.substr(pos, end - pos));
+        if (length > scheme) {
+            std::string uri(s.substr(pos, length));
+            if (uri[0] == 'w') {
+                uri.insert(0, "http://");
+            }
+            links.push_back(Link{glyphAt(pos), glyphAt(pos + length), std::move(uri)});
+        }
+        pos = end;
+    }
+    return LinkMap(std::move(links));
+}
+
+LinkMap::LinkMap(std::vector<Link> links) : links_(std::move(links)) {
+    std::sort(links_.begin(), links_.end(), [](const Link& a, const Link& b) { return a.first < b.first; });
+}
+
+const Link* LinkMap::at(std::uint32_t glyph) const noexcept {
+    // The last link starting at or before `glyph`
+    const auto it = std::upper_bound(links_.begin(), links_.end(), glyph,
+                                     [](std::uint32_t g, const Link& l) { return g < l.first; });
+    if (it == links_.begin() || glyph >= (it - 1)->last) {
+        return nullptr;
+    }
+    return &*(it - 1);
+}
+} // namespace yapdf
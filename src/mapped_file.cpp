@@ -0,0 +1,86 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace yapdf {
+MappedFile::MappedFile(const std::string& path, bool copy) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1) {
+        const int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "stat " + path);
+    }
+
+    // mmap refuses zero-length mappings
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (copy) {
+        // The file may change while it's read, the bytes read are what it holds
+        copy_.resize(size_);
+        std::size_t done = 0;
+        while (done < size_) {
+            const ssize_t n = ::read(fd, copy_.data() + done, size_ - done);
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            if (n == -1) {
+                const int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "read " + path);
+            }
+            if (n == 0) {
+                break;
+            }
+            done += static_cast<std::size_t>(n);
+        }
+        copy_.resize(done);
+        size_ = done;
+        data_ = copy_.empty() ? nullptr : copy_.data();
+    } else if (size_ > 0) {
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            const int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "mmap " + path);
+        }
+        data_ = static_cast<const char*>(p);
+    }
+
+    if (copy) {
+        ::close(fd);
+    } else {
+        fd_ = fd;
+        mtime_ = st.st_mtim;
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data_ && copy_.empty()) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+bool MappedFile::changed() const noexcept {
+    struct stat st;
+    if (fd_ == -1 || ::fstat(fd_, &st) == -1) {
+        return false;
+    }
+    return static_cast<std::size_t>(st.st_size) != size_ || st.st_mtim.tv_sec != mtime_.tv_sec ||
+           st.st_mtim.tv_nsec != mtime_.tv_nsec;
+}
+} // namespace yapdf
@@ -0,0 +1,104 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mipmap.hpp"
+
+#include "pixel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace yapdf {
+double mipmapBase(double scale) noexcept {
+    return std::exp2(std::ceil(std::log2(scale)));
+}
+
+Mipmap::Mipmap(const RenderKey& key, std::shared_ptr<const Image> base) : key_(key) {
+    levels_.push_back(std::move(base));
+    for (;;) {
+        const Image& prev = *levels_.back();
+        const int width = prev.width() / 2;
+        const int height = prev.height() / 2;
+        if (width < MIPMAP_MIN_SIZE || height < MIPMAP_MIN_SIZE) {
+            break;
+        }
+
+        auto next = std::make_shared<Image>(width, height);
+        for (int y = 0; y < height; ++y) {
+            boxHalve(prev.row(2 * y), prev.row(2 * y + 1), next->row(y), width);
+        }
+        levels_.push_back(std::move(next));
+    }
+    for (const std::shared_ptr<const Image>& level : levels_) {
+        bytes_ += level->size();
+    }
+}
+
+std::pair<double, std::shared_ptr<const Image>> Mipmap::nearest(double scale) const noexcept {
+    std::size_t i = 0;
+    while (i + 1 < levels_.size() && key_.scale / static_cast<double>(std::size_t(1) << (i + 1)) >= scale) {
+        ++i;
+    }
+    return {key_.scale / static_cast<double>(std::size_t(1) << i), levels_[i]};
+}
+
+std::unique_ptr<Image> Mipmap::draw(double scale) const {
+    const Image& base = *levels_[0];
+    const double ratio = scale / key_.scale;
+    auto out = std::make_unique<Image>(std::max(1, static_cast<int>(std::lround(base.width() * ratio))),
+                                       std::max(1, static_cast<int>(std::lround(base.height() * ratio))));
+
+    auto [from, level] = nearest(scale);
+    const Image* src = level.get();
+    // Below the smallest level, keep halving so that bilinear interpolation never shrinks by half or more
+    std::unique_ptr<Image> halved;
+    while (scale * 2 <= from && src->width() / 2 >= out->width() && src->height() / 2 >= out->height()) {
+        auto next = std::make_unique<Image>(src->width() / 2, src->height() / 2);
+        for (int y = 0; y < next->height(); ++y) {
+            boxHalve(src->row(2 * y), src->row(2 * y + 1), next->row(y), next->width());
+        }
+        halved = std::move(next);
+        src = halved.get();
+        from /= 2;
+    }
+
+    if (out->width() == src->width() && out->height() == src->height()) {
+        std::memcpy(out->data(), src->data(), src->size());
+    } else {
+        resizeBilinear(src->row(0), src->width(), src->height(), src->stride() / 4, out->row(0), out->width(),
+                       out->height(), out->stride() / 4);
+    }
+    return out;
+}
+
+std::shared_ptr<const Mipmap> MipmapCache::find(const RenderKey& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto it = lru_.begin(); it != lru_.end(); ++it) {
+        const RenderKey& base = (*it)->key();
+        if (base.sameColors(key) && base.scale >= key.scale) {
+            lru_.splice(lru_.begin(), lru_, it);
+            return lru_.front();
+        }
+    }
+    return nullptr;
+}
+
+void MipmapCache::insert(std::shared_ptr<const Mipmap> mipmap) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const RenderKey& key = mipmap->key();
+    lru_.remove_if([this, &key](const std::shared_ptr<const Mipmap>& m) {
+        if (!m->key().sameColors(key)) {
+            return false;
+        }
+        used_ -= m->bytes();
+        return true;
+    });
+    used_ += mipmap->bytes();
+    lru_.push_front(std::move(mipmap));
+    while (used_ > capacity_ && lru_.size() > 1) {
+        used_ -= lru_.back()->bytes();
+        lru_.pop_back();
+    }
+}
+} // namespace yapdf
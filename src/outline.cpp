@@ -0,0 +1,75 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "outline.hpp"
+
+#include <poppler/cpp/poppler-document.h>
+#include <poppler/cpp/poppler-toc.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace yapdf {
+Outline Outline::extract(const poppler::document& doc) {
+    std::vector<OutlineItem> items;
+    const std::unique_ptr<poppler::toc> toc(doc.create_toc());
+    if (!toc || !toc->root()) {
+        return Outline(std::move(items));
+    }
+
+    // Depth-first with an explicit stack, outlines can be deeper than the call stack allows. Every entry holds the
+    // item whose subtree it closes, or -1 for an item to visit.
+    struct Entry {
+        const poppler::toc_item* item;
+        int depth;
+        std::size_t index;
+    };
+    std::vector<Entry> stack;
+    const auto push = [&stack](const poppler::toc_item* parent, int depth) {
+        const std::vector<poppler::toc_item*> children = parent->children();
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            stack.push_back(Entry{*it, depth, static_cast<std::size_t>(-1)});
+        }
+    };
+
+    push(toc->root(), 0);
+    while (!stack.empty()) {
+        const Entry e = stack.back();
+        stack.pop_back();
+        if (e.index != static_cast<std::size_t>(-1)) {
+            items[e.index].end = static_cast<std::uint32_t>(items.size());
+            continue;
+        }
+
+        const poppler::byte_array title = e.item->title().to_utf8();
+        items.push_back(OutlineItem{std::string(title.begin(), title.end()), e.depth, e.item->is_open(), 0});
+        stack.push_back(Entry{nullptr, e.depth, items.size() - 1});
+        push(e.item, e.depth + 1);
+    }
+    return Outline(std::move(items));
+}
+
+Outline::Outline(std::vector<OutlineItem> items) noexcept : items_(std::move(items)) {}
+
+std::vector<std::uint32_t> Outline::subtree(int item, int depth) const {
+    if (item < -1 || item >= static_cast<int>(items_.size())) {
+        throw std::out_of_range("No such outline item: " + std::to_string(item));
+    }
+
+    const std::uint32_t first = static_cast<std::uint32_t>(item + 1);
+    const std::uint32_t end = item < 0 ? static_cast<std::uint32_t>(items_.size()) : items_[item].end;
+    const int base = item < 0 ? 0 : items_[item].depth + 1;
+
+    // Skip the subtrees too deep, rather than walking them
+    std::vector<std::uint32_t> out;
+    for (std::uint32_t i = first; i < end;) {
+        if (items_[i].depth - base >= depth) {
+            i = items_[i].end;
+            continue;
+        }
+        out.push_back(i++);
+    }
+    return out;
+}
+} // namespace yapdf
@@ -0,0 +1,604 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "pixel.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are compiled for their own target and only called if the CPU supports them
+#if defined(__SSE2__) && defined(__GNUC__)
+#define YAPDF_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+// Average four pixels per channel, rounding to nearest
+inline std::uint32_t average4(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d) noexcept {
+    std::uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const std::uint32_t sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) +
+                                  ((d >> shift) & 0xff) + 2;
+        out |= (sum >> 2) << shift;
+    }
+    return out;
+}
+
+// Interpolate four pixels per channel with 8-bit weights `fx` and `fy` of the right and bottom ones
+inline std::uint32_t lerp4(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d, std::uint32_t fx,
+                           std::uint32_t fy) noexcept {
+    std::uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const std::uint32_t top = ((a >> shift) & 0xff) * (256 - fx) + ((b >> shift) & 0xff) * fx;
+        const std::uint32_t bottom = ((c >> shift) & 0xff) * (256 - fx) + ((d >> shift) & 0xff) * fx;
+        out |= ((top * (256 - fy) + bottom * fy + 0x8000) >> 16) << shift;
+    }
+    return out;
+}
+
+// Scalar kernels of the ones of the same name
+inline std::uint32_t invertLightness1(std::uint32_t px) noexcept {
+    const int a = static_cast<int>(px >> 24);
+    const int r = static_cast<int>((px >> 16) & 0xff);
+    const int g = static_cast<int>((px >> 8) & 0xff);
+    const int b = static_cast<int>(px & 0xff);
+    const int d = a - std::max({r, g, b}) - std::min({r, g, b});
+    // Clamped for pixels that aren't valid premultiplied ones, like the vectorized kernel saturates
+    const auto shift = [d](int c) { return static_cast<std::uint32_t>(std::clamp(c + d, 0, 255)); };
+    return static_cast<std::uint32_t>(a) << 24 | shift(r) << 16 | shift(g) << 8 | shift(b);
+}
+
+// Divide by 255, rounding to nearest, for `t` up to 255 * 255
+inline std::uint32_t div255(std::uint32_t t) noexcept {
+    t += 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// Luminance of a pixel out of its alpha, with Rec. 709 weights summing to 256
+inline std::uint32_t luminance(std::uint32_t px) noexcept {
+    const std::uint32_t y = (54 * ((px >> 16) & 0xff) + 183 * ((px >> 8) & 0xff) + 19 * (px & 0xff) + 128) >> 8;
+    return std::min(y, px >> 24);
+}
+
+inline std::uint32_t remapLuminance1(std::uint32_t px, std::uint32_t dark, std::uint32_t light) noexcept {
+    const std::uint32_t a = px >> 24;
+    const std::uint32_t y = luminance(px);
+    std::uint32_t out = a << 24;
+    for (int shift = 0; shift < 24; shift += 8) {
+        out |= div255(((dark >> shift) & 0xff) * (a - y) + ((light >> shift) & 0xff) * y) << shift;
+    }
+    return out;
+}
+
+inline bool isForeground(std::uint32_t px, std::uint32_t background, int tolerance) noexcept {
+    for (int shift = 0; shift < 32; shift += 8) {
+        const int d = static_cast<int>((px >> shift) & 0xff) - static_cast<int>((background >> shift) & 0xff);
+        if (d > tolerance || -d > tolerance) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef __SSE2__
+// Return a bit per pixel of `x` set if it differs from `background` by more than `tolerance` in any channel
+inline int foregroundMask(__m128i x, __m128i background, __m128i tolerance) noexcept {
+    const __m128i diff = _mm_or_si128(_mm_subs_epu8(x, background), _mm_subs_epu8(background, x));
+    const __m128i near = _mm_cmpeq_epi32(_mm_subs_epu8(diff, tolerance), _mm_setzero_si128());
+    return ~_mm_movemask_ps(_mm_castsi128_ps(near)) & 0xf;
+}
+#endif
+
+// Return the source position of destination pixel `i` in 16.16 fixed point, aligning pixel centers
+inline std::int64_t sourcePosition(int i, int src, int dst) noexcept {
+    const std::int64_t pos = ((2 * static_cast<std::int64_t>(i) + 1) * src * 65536) / (2 * dst) - 32768;
+    return pos < 0 ? 0 : pos;
+}
+
+inline std::uint32_t premultiply1(std::uint32_t px) noexcept {
+    const std::uint32_t a = px >> 24;
+    std::uint32_t out = a << 24;
+    for (int shift = 0; shift < 24; shift += 8) {
+        out |= div255(((px >> shift) & 0xff) * a) << shift;
+    }
+    return out;
+}
+
+inline std::uint32_t unpremultiply1(std::uint32_t px) noexcept {
+    const std::uint32_t a = px >> 24;
+    if (a == 0) {
+        return 0;
+    }
+
+    std::uint32_t out = a << 24;
+    for (int shift = 0; shift < 24; shift += 8) {
+        out |= std::min<std::uint32_t>(255, (510 * ((px >> shift) & 0xff) + a) / (2 * a)) << shift;
+    }
+    return out;
+}
+
+void premultiplyScalar(std::uint32_t* row, int n) noexcept {
+    for (int i = 0; i < n; ++i) {
+        row[i] = premultiply1(row[i]);
+    }
+}
+
+void unpremultiplyScalar(std::uint32_t* row, int n) noexcept {
+    for (int i = 0; i < n; ++i) {
+        row[i] = unpremultiply1(row[i]);
+    }
+}
+
+// Red comes first in memory for `Rgb24`, blue for `Bgr24`
+void fromRgbScalar(const std::uint8_t* src, std::uint32_t* dst, int n, bool bgr) noexcept {
+    const int r = bgr ? 2 : 0;
+    for (int i = 0; i < n; ++i, src += 3) {
+        dst[i] = 0xff000000 | std::uint32_t(src[r]) << 16 | std::uint32_t(src[1]) << 8 | src[2 - r];
+    }
+}
+
+void fromGrayScalar(const std::uint8_t* src, std::uint32_t* dst, int n) noexcept {
+    for (int i = 0; i < n; ++i) {
+        dst[i] = 0xff000000 | 0x010101 * std::uint32_t(src[i]);
+    }
+}
+
+void toRgbScalar(const std::uint32_t* src, std::uint8_t* dst, int n) noexcept {
+    for (int i = 0; i < n; ++i) {
+        *dst++ = static_cast<std::uint8_t>(src[i] >> 16);
+        *dst++ = static_cast<std::uint8_t>(src[i] >> 8);
+        *dst++ = static_cast<std::uint8_t>(src[i]);
+    }
+}
+
+#ifdef __SSE2__
+// Multiply 16-bit lanes holding 8-bit values and divide by 255, rounding to nearest
+inline __m128i mulDiv255(__m128i a, __m128i b) noexcept {
+    const __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Return the factors that premultiply the 2 pixels of 16-bit lanes `px`: their alpha for colors, 255 for alpha
+inline __m128i alphaFactors(__m128i px) noexcept {
+    const __m128i alpha =
+        _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_or_si128(_mm_and_si128(alpha, _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1)),
+                        _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+}
+
+void premultiplySse2(std::uint32_t* row, int n) noexcept {
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        const __m128i lo = _mm_unpacklo_epi8(x, zero);
+        const __m128i hi = _mm_unpackhi_epi8(x, zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i),
+                         _mm_packus_epi16(mulDiv255(lo, alphaFactors(lo)), mulDiv255(hi, alphaFactors(hi))));
+    }
+    premultiplyScalar(row + i, n - i);
+}
+
+// Unpremultiply one pixel widened to 32-bit lanes. The color lanes compute floor(c * 255 / a + 0.5), exactly since
+// c * 255 is and the division is correctly rounded. 0 / 0 and c / 0 convert to INT_MIN, which packing saturates to 0.
+inline __m128i unpremultiply4(__m128i px) noexcept {
+    const __m128 a = _mm_cvtepi32_ps(_mm_shuffle_epi32(px, _MM_SHUFFLE(3, 3, 3, 3)));
+    const __m128 c = _mm_mul_ps(_mm_cvtepi32_ps(px), _mm_set1_ps(255.0f));
+    const __m128i q = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(c, a), _mm_set1_ps(0.5f)));
+    const __m128i colors = _mm_set_epi32(0, -1, -1, -1);
+    return _mm_or_si128(_mm_and_si128(q, colors), _mm_andnot_si128(colors, px));
+}
+
+void unpremultiplySse2(std::uint32_t* row, int n) noexcept {
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        const __m128i lo = _mm_unpacklo_epi8(x, zero);
+        const __m128i hi = _mm_unpackhi_epi8(x, zero);
+        const __m128i p01 = _mm_packs_epi32(unpremultiply4(_mm_unpacklo_epi16(lo, zero)),
+                                            unpremultiply4(_mm_unpackhi_epi16(lo, zero)));
+        const __m128i p23 = _mm_packs_epi32(unpremultiply4(_mm_unpacklo_epi16(hi, zero)),
+                                            unpremultiply4(_mm_unpackhi_epi16(hi, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), _mm_packus_epi16(p01, p23));
+    }
+    unpremultiplyScalar(row + i, n - i);
+}
+
+void fromGraySse2(const std::uint8_t* src, std::uint32_t* dst, int n) noexcept {
+    const __m128i opaque = _mm_set1_epi8(-1);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // Interleave g, g and g, 0xff, then both pairs: 4 bytes g, g, g, 0xff per pixel
+        const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i ggLo = _mm_unpacklo_epi8(g, g);
+        const __m128i gaLo = _mm_unpacklo_epi8(g, opaque);
+        const __m128i ggHi = _mm_unpackhi_epi8(g, g);
+        const __m128i gaHi = _mm_unpackhi_epi8(g, opaque);
+        auto* out = reinterpret_cast<__m128i*>(dst + i);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(ggLo, gaLo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(ggLo, gaLo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(ggHi, gaHi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(ggHi, gaHi));
+    }
+    fromGrayScalar(src + i, dst + i, n - i);
+}
+#endif
+
+#ifdef YAPDF_HAVE_AVX2
+// The AVX2 versions of the SSE2 kernels, 8 pixels at a time. Instructions work within 128-bit lanes, and so does
+// packing, so the pixel order comes out right.
+__attribute__((target("avx2"))) inline __m256i mulDiv255Avx2(__m256i a, __m256i b) noexcept {
+    const __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2"))) inline __m256i alphaFactorsAvx2(__m256i px) noexcept {
+    const __m256i alpha =
+        _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm256_or_si256(
+        _mm256_and_si256(alpha, _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1)),
+        _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0));
+}
+
+__attribute__((target("avx2"))) void premultiplyAvx2(std::uint32_t* row, int n) noexcept {
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        const __m256i lo = _mm256_unpacklo_epi8(x, zero);
+        const __m256i hi = _mm256_unpackhi_epi8(x, zero);
+        const __m256i out =
+            _mm256_packus_epi16(mulDiv255Avx2(lo, alphaFactorsAvx2(lo)), mulDiv255Avx2(hi, alphaFactorsAvx2(hi)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i), out);
+    }
+    premultiplyScalar(row + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline __m256i unpremultiply8(__m256i px) noexcept {
+    const __m256 a = _mm256_cvtepi32_ps(_mm256_shuffle_epi32(px, _MM_SHUFFLE(3, 3, 3, 3)));
+    const __m256 c = _mm256_mul_ps(_mm256_cvtepi32_ps(px), _mm256_set1_ps(255.0f));
+    const __m256i q = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_div_ps(c, a), _mm256_set1_ps(0.5f)));
+    return _mm256_blend_epi32(q, px, 0x88);
+}
+
+__attribute__((target("avx2"))) void unpremultiplyAvx2(std::uint32_t* row, int n) noexcept {
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        const __m256i lo = _mm256_unpacklo_epi8(x, zero);
+        const __m256i hi = _mm256_unpackhi_epi8(x, zero);
+        const __m256i p01 = _mm256_packs_epi32(unpremultiply8(_mm256_unpacklo_epi16(lo, zero)),
+                                               unpremultiply8(_mm256_unpackhi_epi16(lo, zero)));
+        const __m256i p23 = _mm256_packs_epi32(unpremultiply8(_mm256_unpacklo_epi16(hi, zero)),
+                                               unpremultiply8(_mm256_unpackhi_epi16(hi, zero)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i), _mm256_packus_epi16(p01, p23));
+    }
+    unpremultiplyScalar(row + i, n - i);
+}
+
+__attribute__((target("avx2"))) void fromRgbAvx2(const std::uint8_t* src, std::uint32_t* dst, int n,
+                                                  bool bgr) noexcept {
+    // Each 128-bit lane gathers 4 pixels out of 12 bytes, loading 16
+    const __m256i order = bgr ? _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3,
+                                                 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1)
+                              : _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1, 2, 1, 0, -1, 5,
+                                                 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xff000000));
+    int i = 0;
+    // The second load reads up to byte 3 * i + 28
+    for (; i + 10 <= n; i += 8) {
+        const std::uint8_t* p = src + 3 * static_cast<std::size_t>(i);
+        const __m256i x = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+        const __m256i out = _mm256_or_si256(_mm256_shuffle_epi8(x, order), opaque);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out);
+    }
+    fromRgbScalar(src + 3 * static_cast<std::size_t>(i), dst + i, n - i, bgr);
+}
+
+__attribute__((target("avx2"))) void toRgbAvx2(const std::uint32_t* src, std::uint8_t* dst, int n) noexcept {
+    // Each 128-bit lane packs 4 pixels into its low 12 bytes
+    const __m256i order = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4,
+                                           10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    int i = 0;
+    // The second store writes up to byte 3 * i + 28, later pixels overwrite the padding
+    for (; i + 10 <= n; i += 8) {
+        const __m256i x = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), order);
+        std::uint8_t* p = dst + 3 * static_cast<std::size_t>(i);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 12), _mm256_extracti128_si256(x, 1));
+    }
+    toRgbScalar(src + i, dst + 3 * static_cast<std::size_t>(i), n - i);
+}
+#endif
+
+std::atomic<yapdf::Simd>& level() noexcept {
+    static std::atomic<yapdf::Simd> level{yapdf::detectSimd()};
+    return level;
+}
+} // namespace
+
+namespace yapdf {
+Simd detectSimd() noexcept {
+#ifdef YAPDF_HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Simd::Avx2;
+    }
+#endif
+#ifdef __SSE2__
+    return Simd::Sse2;
+#else
+    return Simd::Scalar;
+#endif
+}
+
+Simd simd() noexcept {
+    return level().load(std::memory_order_relaxed);
+}
+
+Simd useSimd(Simd wanted) noexcept {
+    const Simd used = std::min(wanted, detectSimd());
+    level().store(used, std::memory_order_relaxed);
+    return used;
+}
+
+void toArgb32(PixelFormat format, const std::uint8_t* src, std::uint32_t* dst, int n) noexcept {
+    [[maybe_unused]] const Simd used = simd();
+    switch (format) {
+    case PixelFormat::Gray8:
+#ifdef __SSE2__
+        if (used >= Simd::Sse2) {
+            fromGraySse2(src, dst, n);
+            return;
+        }
+#endif
+        fromGrayScalar(src, dst, n);
+        return;
+    case PixelFormat::Rgb24:
+    case PixelFormat::Bgr24:
+#ifdef YAPDF_HAVE_AVX2
+        if (used == Simd::Avx2) {
+            fromRgbAvx2(src, dst, n, format == PixelFormat::Bgr24);
+            return;
+        }
+#endif
+        fromRgbScalar(src, dst, n, format == PixelFormat::Bgr24);
+        return;
+    case PixelFormat::StraightArgb32:
+        std::memcpy(dst, src, static_cast<std::size_t>(n) * 4);
+        premultiply(dst, n);
+        return;
+    case PixelFormat::Argb32:
+        std::memcpy(dst, src, static_cast<std::size_t>(n) * 4);
+        return;
+    }
+}
+
+void toRgb24(const std::uint32_t* src, std::uint8_t* dst, int n) noexcept {
+#ifdef YAPDF_HAVE_AVX2
+    if (simd() == Simd::Avx2) {
+        toRgbAvx2(src, dst, n);
+        return;
+    }
+#endif
+    toRgbScalar(src, dst, n);
+}
+
+void premultiply(std::uint32_t* row, int n) noexcept {
+    switch (simd()) {
+#ifdef YAPDF_HAVE_AVX2
+    case Simd::Avx2:
+        premultiplyAvx2(row, n);
+        return;
+#endif
+#ifdef __SSE2__
+    case Simd::Sse2:
+        premultiplySse2(row, n);
+        return;
+#endif
+    default:
+        premultiplyScalar(row, n);
+        return;
+    }
+}
+
+void unpremultiply(std::uint32_t* row, int n) noexcept {
+    switch (simd()) {
+#ifdef YAPDF_HAVE_AVX2
+    case Simd::Avx2:
+        unpremultiplyAvx2(row, n);
+        return;
+#endif
+#ifdef __SSE2__
+    case Simd::Sse2:
+        unpremultiplySse2(row, n);
+        return;
+#endif
+    default:
+        unpremultiplyScalar(row, n);
+        return;
+    }
+}
+
+void boxHalve(const std::uint32_t* row0, const std::uint32_t* row1, std::uint32_t* out, int n) noexcept {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+
+    // 4 source pixels of each row make 2 output pixels
+    for (; i + 2 <= n; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * i));
+
+        // Widen channels to 16 bits and sum vertically: `lo` holds pixels 0 and 1, `hi` pixels 2 and 3
+        const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+        // Sum horizontally: the low 64 bits get pixel 0 + 1 and pixel 2 + 3 respectively
+        const __m128i l = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        const __m128i h = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+        const __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(l, h), two), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(sum, sum));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        out[i] = average4(row0[2 * i], row0[2 * i + 1], row1[2 * i], row1[2 * i + 1]);
+    }
+}
+
+void invertLightness(std::uint32_t* row, int n) noexcept {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low = _mm_set1_epi32(0xff);
+    // The color channels of two pixels widened to 16 bits
+    const __m128i colors = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+
+        // The low byte of each lane gets max and min of b, g and r
+        const __m128i g = _mm_srli_epi32(x, 8);
+        const __m128i r = _mm_srli_epi32(x, 16);
+        const __m128i max = _mm_and_si128(_mm_max_epu8(_mm_max_epu8(x, g), r), low);
+        const __m128i min = _mm_and_si128(_mm_min_epu8(_mm_min_epu8(x, g), r), low);
+        const __m128i d = _mm_sub_epi32(_mm_sub_epi32(_mm_srli_epi32(x, 24), max), min);
+
+        // Spread the offset of each pixel over its color channels
+        const __m128i d16 = _mm_packs_epi32(d, d);
+        const __m128i dd = _mm_unpacklo_epi16(d16, d16);
+        const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(x, zero), _mm_and_si128(_mm_unpacklo_epi32(dd, dd), colors));
+        const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(x, zero), _mm_and_si128(_mm_unpackhi_epi32(dd, dd), colors));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        row[i] = invertLightness1(row[i]);
+    }
+}
+
+void remapLuminance(std::uint32_t* row, int n, std::uint32_t dark, std::uint32_t light) noexcept {
+    // Opaque, so that alpha maps to itself
+    dark |= 0xff000000;
+    light |= 0xff000000;
+
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights = _mm_set_epi16(0, 54, 183, 19, 0, 54, 183, 19);
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i darks = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(dark)), zero);
+    const __m128i lights = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(light)), zero);
+
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        const __m128i lo = _mm_unpacklo_epi8(x, zero);
+        const __m128i hi = _mm_unpackhi_epi8(x, zero);
+
+        // Weighted sums of b + g and r + a land in adjacent 32-bit lanes, add them and gather the 4 pixels
+        const __m128i wl = _mm_madd_epi16(lo, weights);
+        const __m128i wh = _mm_madd_epi16(hi, weights);
+        const __m128i sl = _mm_add_epi32(wl, _mm_srli_epi64(wl, 32));
+        const __m128i sh = _mm_add_epi32(wh, _mm_srli_epi64(wh, 32));
+        const __m128i sum = _mm_castps_si128(
+            _mm_shuffle_ps(_mm_castsi128_ps(sl), _mm_castsi128_ps(sh), _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i y32 = _mm_srli_epi32(_mm_add_epi32(sum, round), 8);
+
+        // 16 bits from here on: y and a - y of every pixel, spread over its channels
+        const __m128i a = _mm_packs_epi32(_mm_srli_epi32(x, 24), zero);
+        const __m128i y = _mm_min_epi16(_mm_packs_epi32(y32, zero), a);
+        const __m128i yy = _mm_unpacklo_epi16(y, y);
+        const __m128i ii = _mm_unpacklo_epi16(_mm_sub_epi16(a, y), _mm_sub_epi16(a, y));
+
+        // dark * (a - y) + light * y fits in 16 bits unsigned, then divide by 255
+        const auto blend = [&](__m128i inv, __m128i lum) {
+            const __m128i t = _mm_add_epi16(
+                _mm_add_epi16(_mm_mullo_epi16(darks, inv), _mm_mullo_epi16(lights, lum)), half);
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        };
+        const __m128i outLo = blend(_mm_unpacklo_epi32(ii, ii), _mm_unpacklo_epi32(yy, yy));
+        const __m128i outHi = blend(_mm_unpackhi_epi32(ii, ii), _mm_unpackhi_epi32(yy, yy));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), _mm_packus_epi16(outLo, outHi));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        row[i] = remapLuminance1(row[i], dark, light);
+    }
+}
+
+std::pair<int, int> foregroundSpan(const std::uint32_t* row, int n, std::uint32_t background, int tolerance) noexcept {
+    tolerance = std::clamp(tolerance, 0, 255);
+    int first = 0;
+#ifdef __SSE2__
+    const __m128i bg = _mm_set1_epi32(static_cast<int>(background));
+    const __m128i tol = _mm_set1_epi8(static_cast<char>(tolerance));
+    for (; first + 4 <= n; first += 4) {
+        const int mask = foregroundMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + first)), bg, tol);
+        if (mask != 0) {
+            first += __builtin_ctz(static_cast<unsigned>(mask));
+            break;
+        }
+    }
+#endif
+    while (first < n && !isForeground(row[first], background, tolerance)) {
+        ++first;
+    }
+    if (first == n) {
+        return {0, 0};
+    }
+
+    // There's a foreground pixel at `first`, so the scan from the end stops there at the latest
+    int last = n;
+#ifdef __SSE2__
+    for (; last - 4 >= first; last -= 4) {
+        const int mask = foregroundMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + last - 4)), bg, tol);
+        if (mask != 0) {
+            return {first, last - 4 + 32 - __builtin_clz(static_cast<unsigned>(mask))};
+        }
+    }
+#endif
+    while (!isForeground(row[last - 1], background, tolerance)) {
+        --last;
+    }
+    return {first, last};
+}
+
+void resizeBilinear(const std::uint32_t* src, int srcWidth, int srcHeight, std::size_t srcStride, std::uint32_t* dst,
+                    int dstWidth, int dstHeight, std::size_t dstStride) noexcept {
+    if (srcWidth <= 0 || srcHeight <= 0) {
+        return;
+    }
+
+    for (int y = 0; y < dstHeight; ++y) {
+        const std::int64_t sy = sourcePosition(y, srcHeight, dstHeight);
+        const int y0 = std::min(static_cast<int>(sy >> 16), srcHeight - 1);
+        const int y1 = std::min(y0 + 1, srcHeight - 1);
+        const auto fy = static_cast<std::uint32_t>((sy >> 8) & 0xff);
+        const std::uint32_t* row0 = src + srcStride * y0;
+        const std::uint32_t* row1 = src + srcStride * y1;
+        std::uint32_t* out = dst + dstStride * y;
+
+        for (int x = 0; x < dstWidth; ++x) {
+            const std::int64_t sx = sourcePosition(x, srcWidth, dstWidth);
+            const int x0 = std::min(static_cast<int>(sx >> 16), srcWidth - 1);
+            const int x1 = std::min(x0 + 1, srcWidth - 1);
+            const auto fx = static_cast<std::uint32_t>((sx >> 8) & 0xff);
+            out[x] = lerp4(row0[x0], row0[x1], row1[x0], row1[x1], fx, fy);
+        }
+    }
+}
+} // namespace yapdf
@@ -0,0 +1,323 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "render.hpp"
+
+#include "compress.hpp"
+#include "disk_cache.hpp"
+#include "pixel.hpp"
+
+#include <poppler/cpp/poppler-image.h>
+#include <poppler/cpp/poppler-page-renderer.h>
+#include <poppler/cpp/poppler-page.h>
+
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace yapdf {
+std::shared_ptr<Image> rasterizePage(const Document& doc, int page, double scale) {
+    const poppler::image raw = doc.use([page, scale](const poppler::document& d) {
+        const std::unique_ptr<poppler::page> p(d.create_page(page));
+        if (!p) {
+            throw std::runtime_error("Failed to load page " + std::to_string(page));
+        }
+
+        poppler::page_renderer renderer;
+        renderer.set_image_format(poppler::image::format_argb32);
+        renderer.set_render_hint(poppler::page_renderer::antialiasing);
+        renderer.set_render_hint(poppler::page_renderer::text_antialiasing);
+        return renderer.render_page(p.get(), 72.0 * scale, 72.0 * scale);
+    });
+    if (!raw.is_valid()) {
+        throw std::runtime_error("Failed to render page " + std::to_string(page));
+    }
+
+    // poppler-cpp doesn't promise premultiplied alpha. Its pages are opaque on the default paper, which premultiplying
+    // leaves alone.
+    PixelFormat format;
+    switch (raw.format()) {
+    case poppler::image::format_gray8:
+        format = PixelFormat::Gray8;
+        break;
+    case poppler::image::format_rgb24:
+        format = PixelFormat::Rgb24;
+        break;
+    case poppler::image::format_bgr24:
+        format = PixelFormat::Bgr24;
+        break;
+    case poppler::image::format_argb32:
+        format = PixelFormat::StraightArgb32;
+        break;
+    default:
+        throw std::runtime_error("Unsupported image format of page " + std::to_string(page));
+    }
+
+    // poppler pads rows differently
+    auto img = std::make_shared<Image>(raw.width(), raw.height());
+    for (int y = 0; y < img->height(); ++y) {
+        const auto* src =
+            reinterpret_cast<const std::uint8_t*>(raw.const_data() + static_cast<std::size_t>(raw.bytes_per_row()) * y);
+        toArgb32(format, src, img->row(y), img->width());
+    }
+    return img;
+}
+
+void applyColorMode(Image& img, const RenderKey& key) noexcept {
+    for (int y = 0; y < img.height(); ++y) {
+        std::uint32_t* row = img.row(y);
+        switch (key.mode) {
+        case ColorMode::Normal:
+            return;
+        case ColorMode::Dark:
+            invertLightness(row, img.width());
+            break;
+        case ColorMode::Sepia:
+            remapLuminance(row, img.width(), SEPIA_FOREGROUND, SEPIA_BACKGROUND);
+            break;
+        case ColorMode::Colormap:
+            remapLuminance(row, img.width(), key.foreground, key.background);
+            break;
+        }
+    }
+}
+
+Renderer::Renderer(std::shared_ptr<Document> doc, std::size_t capacity) noexcept
+    : doc_(std::move(doc)), capacity_(capacity) {}
+
+Renderer::Result Renderer::render(const RenderKey& key, Priority prio) {
+    if (key.page < 0 || key.page >= doc_->pages()) {
+        throw std::out_of_range("No such page: " + std::to_string(key.page));
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    if (auto it = cache_.find(key); it != cache_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+
+        std::promise<std::shared_ptr<const Image>> ready;
+        ready.set_value(it->second->second);
+        return ready.get_future().share();
+    }
+
+    if (auto it = flights_.find(key); it != flights_.end()) {
+        Flight& flight = it->second;
+        if (prio > flight.prio) {
+            ThreadPool::getInstance().raise(flight.job, prio);
+            flight.prio = prio;
+        }
+        return flight.result;
+    }
+
+    // `land` waits for `mu_`, so the flight is registered before the job can finish. Waiters are served before
+    // `land` compresses the pages the result evicts, a request joining the flight meanwhile gets the ready result.
+    auto promise = std::make_shared<std::promise<std::shared_ptr<const Image>>>();
+    Result result = promise->get_future().share();
+    auto job = ThreadPool::getInstance().post(
+        [self = shared_from_this(), key, promise] {
+            std::shared_ptr<const Image> img;
+            try {
+                img = self->rasterize(key);
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+                self->land(key, nullptr);
+                return;
+            }
+            promise->set_value(img);
+            self->land(key, std::move(img));
+        },
+        prio);
+    flights_.emplace(key, Flight{result, std::move(job), prio});
+    return result;
+}
+
+void Renderer::insert(const RenderKey& key, std::shared_ptr<const Image> img) {
+    std::vector<Entry> victims;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        admit(key, std::move(img), victims);
+    }
+    freeze(std::move(victims));
+}
+
+std::shared_ptr<const Image> Renderer::cached(const RenderKey& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        return nullptr;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+}
+
+std::pair<RenderKey, std::shared_ptr<const Image>> Renderer::nearest(const RenderKey& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const Entry* best = nullptr;
+    double bestDistance = 0;
+    for (const Entry& e : lru_) {
+        if (!e.first.sameColors(key)) {
+            continue;
+        }
+
+        // Compare ratios, so that half the scale is as far as twice, and prefer downscaling which stays sharp
+        const double distance = std::abs(std::log(e.first.scale / key.scale)) - (e.first.scale > key.scale ? 1e-9 : 0);
+        if (!best || distance < bestDistance) {
+            best = &e;
+            bestDistance = distance;
+        }
+    }
+    if (!best) {
+        return {key, nullptr};
+    }
+    return *best;
+}
+
+std::pair<std::size_t, std::size_t> Renderer::usage() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return {used_, coldUsed_};
+}
+
+std::shared_ptr<const Image> Renderer::rasterize(const RenderKey& key) {
+    if (std::shared_ptr<const Image> img = thaw(key)) {
+        return img;
+    }
+
+    const RenderKey normal{key.page, key.scale};
+    std::shared_ptr<const Image> img;
+    if (key.mode != ColorMode::Normal) {
+        img = cached(normal);
+        if (!img) {
+            img = thaw(normal);
+        }
+    }
+
+    const std::shared_ptr<DiskCache> disk = DiskCache::global();
+    if (!img && disk) {
+        img = disk->load(doc_->hash(), normal);
+    }
+    if (!img) {
+        std::shared_ptr<Image> raw = rasterizePage(*doc_, key.page, key.scale);
+        if (disk) {
+            disk->store(doc_->hash(), normal, *raw);
+        }
+        img = std::move(raw);
+    }
+    if (key.mode == ColorMode::Normal) {
+        return img;
+    }
+
+    // The normal rendering may be cached or shared, transform a copy
+    auto out = std::make_shared<Image>(img->width(), img->height());
+    std::memcpy(out->data(), img->data(), img->size());
+    applyColorMode(*out, key);
+    return out;
+}
+
+std::shared_ptr<const Image> Renderer::thaw(const RenderKey& key) {
+    std::shared_ptr<const Frozen> frozen;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        const auto it = coldIndex_.find(key);
+        if (it == coldIndex_.end()) {
+            return nullptr;
+        }
+        frozen = it->second->second;
+    }
+
+    // The page stays cold until it lands in the hot tier
+    return decompress(*frozen);
+}
+
+std::shared_ptr<const Image> Renderer::decompress(const Frozen& frozen) {
+    auto img = std::make_shared<Image>(frozen.width, frozen.height);
+    const std::size_t n = static_cast<std::size_t>(img->width()) * img->height();
+    if (!decompressPixels(frozen.data.data(), frozen.data.size(), img->row(0), n)) {
+        return nullptr;
+    }
+    return img;
+}
+
+void Renderer::land(const RenderKey& key, std::shared_ptr<const Image> img) {
+    std::vector<Entry> victims;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        flights_.erase(key);
+        if (!img) {
+            return;
+        }
+        admit(key, std::move(img), victims);
+    }
+
+    // Compressing takes a while, the lock isn't held meanwhile
+    freeze(std::move(victims));
+}
+
+void Renderer::admit(const RenderKey& key, std::shared_ptr<const Image> img, std::vector<Entry>& victims) {
+    if (const auto it = coldIndex_.find(key); it != coldIndex_.end()) {
+        coldUsed_ -= it->second->second->data.size();
+        cold_.erase(it->second);
+        coldIndex_.erase(it);
+    }
+    // Inserted while its flight was running
+    if (const auto it = cache_.find(key); it != cache_.end()) {
+        used_ -= it->second->second->size();
+        lru_.erase(it->second);
+        cache_.erase(it);
+    }
+
+    used_ += img->size();
+    lru_.emplace_front(key, std::move(img));
+    cache_[key] = lru_.begin();
+
+    // Keep at least the newest page even if it's over budget
+    const std::size_t hot = capacity_ - capacity_ / RENDER_COLD_SHARE;
+    while (used_ > hot && lru_.size() > 1) {
+        Entry& victim = lru_.back();
+        used_ -= victim.second->size();
+        cache_.erase(victim.first);
+        victims.push_back(std::move(victim));
+        lru_.pop_back();
+    }
+}
+
+void Renderer::freeze(std::vector<Entry> victims) noexcept {
+    for (const Entry& victim : victims) {
+        try {
+            const Image& img = *victim.second;
+            auto frozen = std::make_shared<Frozen>();
+            frozen->width = img.width();
+            frozen->height = img.height();
+            for (int y = 0; y < img.height(); ++y) {
+                compressPixels(img.row(y), img.width(), frozen->data);
+            }
+
+            // Not worth the decompression
+            if (frozen->data.size() > img.size() / 2) {
+                continue;
+            }
+            frozen->data.shrink_to_fit();
+
+            std::lock_guard<std::mutex> lock(mu_);
+            // Rendered again meanwhile
+            if (cache_.count(victim.first) || coldIndex_.count(victim.first)) {
+                continue;
+            }
+
+            const std::size_t bytes = frozen->data.size();
+            cold_.emplace_front(victim.first, std::move(frozen));
+            coldUsed_ += bytes;
+            coldIndex_[victim.first] = cold_.begin();
+            while (used_ + coldUsed_ > capacity_ && !cold_.empty()) {
+                const ColdEntry& old = cold_.back();
+                coldUsed_ -= old.second->data.size();
+                coldIndex_.erase(old.first);
+                cold_.pop_back();
+            }
+        } catch (const std::bad_alloc&) {
+            // The page is dropped
+        }
+    }
+}
+} // namespace yapdf
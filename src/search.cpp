@@ -0,0 +1,401 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "search.hpp"
+
+#include "substring.hpp"
+#include "thread_pool.hpp"
+#include "unicode.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <exception>
+
+namespace {
+char foldAscii(char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool equalFolded(std::string_view a, std::string_view b) noexcept {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return foldAscii(x) == foldAscii(y); });
+}
+
+// Return the index of the first glyph starting at or after byte `pos`
+std::uint32_t glyphAfter(const std::vector<std::uint32_t>& offsets, std::size_t pos) noexcept {
+    return static_cast<std::uint32_t>(std::lower_bound(offsets.begin(), offsets.end(), pos) - offsets.begin());
+}
+
+// Return the index of the glyph folded to byte `pos` of `text`, or the next glyph if it's a separator. A match may
+// start inside a glyph folded to several bytes, e.g. "fi" from a ligature.
+std::uint32_t glyphOf(std::string_view text, const std::vector<std::uint32_t>& offsets, std::size_t pos) noexcept {
+    if (text[pos] == ' ' || text[pos] == '\n') {
+        return glyphAfter(offsets, pos);
+    }
+
+    const auto it = std::upper_bound(offsets.begin(), offsets.end(), pos);
+    return static_cast<std::uint32_t>(it == offsets.begin() ? 0 : it - offsets.begin() - 1);
+}
+
+// Return the end of the escape whose letter is at `i` of `pattern`, past its code, name or backreference digits
+std::size_t escapeEnd(std::string_view pattern, std::size_t i) noexcept {
+    const auto skip = [&](std::size_t n, auto pred) {
+        std::size_t end = i + 1;
+        while (end < pattern.size() && end - i - 1 < n && pred(pattern[end])) {
+            ++end;
+        }
+        return end;
+    };
+    const auto hex = [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; };
+    const auto digit = [](char c) { return c >= '0' && c <= '9'; };
+
+    switch (pattern[i]) {
+    case 'x':
+        return skip(2, hex);
+    case 'u':
+        return skip(4, hex);
+    case 'c':
+        return skip(1, [](char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; });
+    case 'k':
+        // `\k<name>`
+        if (i + 1 < pattern.size() && pattern[i + 1] == '<') {
+            return std::min(pattern.find('>', i), pattern.size() - 1) + 1;
+        }
+        return i + 1;
+    default:
+        if (digit(pattern[i])) {
+            return skip(pattern.size(), digit);
+        }
+        return i + 1;
+    }
+}
+
+void appendBox(std::string& s, const yapdf::Box& box) {
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "(%.2f %.2f %.2f %.2f)", box.x0, box.y0, box.x1, box.y1);
+    s += buf;
+}
+} // namespace
+
+namespace yapdf {
+std::vector<std::uint32_t> occurrences(std::string_view text, std::string_view query, bool foldCase) {
+    std::vector<std::uint32_t> out;
+    if (query.empty()) {
+        return out;
+    }
+
+    for (std::size_t pos = findSubstring(text, query, foldCase); pos != std::string_view::npos;
+         pos = findSubstring(text, query, foldCase, pos + 1)) {
+        out.push_back(static_cast<std::uint32_t>(pos));
+    }
+    return out;
+}
+
+std::string requiredLiteral(std::string_view pattern) {
+    std::string best;
+    std::string run;
+    const auto flush = [&] {
+        if (run.size() > best.size()) {
+            best = run;
+        }
+        run.clear();
+    };
+
+    // Only literals outside groups are surely required, a group may be optional or an alternation
+    int depth = 0;
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        const char c = pattern[i];
+        switch (c) {
+        case '\\':
+            if (++i < pattern.size()) {
+                constexpr std::string_view classes = "bBdDwWsSfnrtv0123456789cxuk";
+                if (depth == 0 && classes.find(pattern[i]) == std::string_view::npos) {
+                    run.push_back(pattern[i]);
+                } else {
+                    i = escapeEnd(pattern, i) - 1;
+                    flush();
+                }
+            }
+            break;
+        case '[':
+            // Skip the class, `]` right after `[` or `[^` is a member
+            i += i + 1 < pattern.size() && pattern[i + 1] == '^' ? 2 : 1;
+            for (bool first = true; i < pattern.size() && (first || pattern[i] != ']'); ++i, first = false) {
+                i += pattern[i] == '\\';
+            }
+            flush();
+            break;
+        case '(':
+            ++depth;
+            flush();
+            break;
+        case ')':
+            --depth;
+            flush();
+            break;
+        case '|':
+            if (depth == 0) {
+                return std::string();
+            }
+            break;
+        case '*':
+        case '?':
+        case '{':
+            // The atom before may be absent, unless it's `{n,m}` with a positive `n`
+            if (c != '{' || pattern.substr(i + 1, 1) == "0" || pattern.substr(i + 1, 1) == ",") {
+                if (!run.empty()) {
+                    run.pop_back();
+                }
+            }
+            flush();
+            if (c == '{') {
+                i = std::min(pattern.find('}', i), pattern.size());
+            }
+            break;
+        case '+':
+        case '.':
+        case '^':
+        case '$':
+            flush();
+            break;
+        default:
+            if (depth == 0) {
+                run.push_back(c);
+            }
+            break;
+        }
+    }
+    flush();
+    return best;
+}
+
+Folding regexFolding(std::string_view pattern, Folding f) {
+    if (f == Folding::None) {
+        return Folding::None;
+    }
+
+    // Folding the pattern itself would break escapes like `\W`. The folded text only fits patterns whose letters
+    // folding leaves alone but for ASCII case, which `icase` takes care of.
+    std::string lower(pattern);
+    std::transform(lower.begin(), lower.end(), lower.begin(), foldAscii);
+    return foldString(pattern, false) == lower ? Folding::Case : Folding::None;
+}
+
+std::vector<Match> regexMatches(const PageText& t, Folding f, const std::regex& re, std::string_view literal) {
+    std::vector<Match> out;
+    const auto [text, offsets] = t.view(f);
+    const bool foldCase = (re.flags() & std::regex::icase) != 0;
+    if (!literal.empty() && findSubstring(text, literal, foldCase) == std::string_view::npos) {
+        return out;
+    }
+
+    // Bound the depth of the recursion of the regex engine, and so the stack, by the length of its input
+    for (std::size_t start = 0; start < text.size();) {
+        const std::size_t eol = std::min(text.find('\n', start), text.size());
+        std::size_t end = eol;
+        if (end - start > REGEX_WINDOW) {
+            // Cut long lines between characters, the next window looks back at the last one for `\b`
+            end = start + REGEX_WINDOW;
+            while ((static_cast<unsigned char>(text[end]) & 0xc0) == 0x80) {
+                --end;
+            }
+        }
+
+        const auto flags = start > 0 && text[start - 1] != '\n' ? std::regex_constants::match_prev_avail
+                                                                  : std::regex_constants::match_default;
+        for (auto it = std::cregex_iterator(text.data() + start, text.data() + end, re, flags);
+             it != std::cregex_iterator(); ++it) {
+            const auto pos = start + static_cast<std::size_t>(it->position());
+            const auto len = static_cast<std::size_t>(it->length());
+            // Skip empty matches and matches of separators only
+            if (len > 0) {
+                const Match m{glyphOf(text, offsets, pos), glyphAfter(offsets, pos + len)};
+                if (m.first < m.last) {
+                    out.push_back(m);
+                }
+            }
+        }
+        start = end == eol ? eol + 1 : end;
+    }
+    return out;
+}
+
+std::vector<std::uint32_t> refine(std::string_view text, const std::vector<std::uint32_t>& positions,
+                                  std::string_view query, bool foldCase) {
+    std::vector<std::uint32_t> out;
+    for (std::uint32_t pos : positions) {
+        const std::string_view s = text.substr(pos, query.size());
+        if (foldCase ? equalFolded(s, query) : s == query) {
+            out.push_back(pos);
+        }
+    }
+    return out;
+}
+
+std::vector<Match> toMatches(const PageText& t, Folding f, const std::vector<std::uint32_t>& positions,
+                             std::size_t length) {
+    const auto [text, offsets] = t.view(f);
+    std::vector<Match> out;
+    std::size_t end = 0;
+    for (std::uint32_t pos : positions) {
+        if (pos < end) {
+            continue;
+        }
+
+        const Match m{glyphOf(text, offsets, pos), glyphAfter(offsets, pos + length)};
+        // Skip matches of separators only
+        if (m.first < m.last) {
+            out.push_back(m);
+            end = pos + length;
+        }
+    }
+    return out;
+}
+
+std::vector<Match> findAll(const PageText& t, std::string_view query, Folding f) {
+    const std::string needle = f == Folding::None ? std::string(query) : foldString(query, f == Folding::Diacritics);
+    return toMatches(t, f, occurrences(t.view(f).first, needle, false), needle.size());
+}
+
+std::vector<Box> boxesOf(const PageText& t, const Match& m) {
+    std::vector<Box> out;
+    for (std::uint32_t i = m.first; i < m.last; ++i) {
+        const Box b = t.box(i);
+        if (!out.empty() && b.y0 < out.back().y1 && out.back().y0 < b.y1) {
+            Box& line = out.back();
+            line.x0 = std::min(line.x0, b.x0);
+            line.y0 = std::min(line.y0, b.y0);
+            line.x1 = std::max(line.x1, b.x1);
+            line.y1 = std::max(line.y1, b.y1);
+        } else {
+            out.push_back(b);
+        }
+    }
+    return out;
+}
+
+Search::Search(std::shared_ptr<Document> doc, std::string query, Folding folding, bool regex)
+    : doc_(std::move(doc)), query_(std::move(query)), folding_(folding), occurrences_(doc_->pages()),
+      scanned_(occurrences_.size()) {
+    if (regex) {
+        // The pattern is matched ignoring case, against the case-folded text if that doesn't lose any of its letters.
+        // The required literal is only folded along with the text.
+        const bool fold = folding_ != Folding::None;
+        folding_ = regexFolding(query_, folding_);
+        regex_.emplace(query_, std::regex::ECMAScript | (fold ? std::regex::icase : std::regex::flag_type()));
+        needle_ = requiredLiteral(query_);
+    } else {
+        needle_ = query_;
+    }
+
+    if (folding_ != Folding::None) {
+        needle_ = foldString(needle_, folding_ == Folding::Diacritics);
+    }
+}
+
+Search::Search(std::shared_ptr<const Search> base, std::string query)
+    : doc_(base->doc_), query_(std::move(query)), folding_(base->folding_),
+      needle_(folding_ == Folding::None ? query_ : foldString(query_, folding_ == Folding::Diacritics)),
+      base_(std::move(base)), occurrences_(doc_->pages()), scanned_(occurrences_.size()) {}
+
+bool Search::refinableTo(std::string_view query, Folding folding, bool regex) const {
+    if (regex || regex_ || folding != folding_ || needle_.empty()) {
+        return false;
+    }
+
+    const std::string needle =
+        folding == Folding::None ? std::string(query) : foldString(query, folding == Folding::Diacritics);
+    return needle.size() >= needle_.size() && std::string_view(needle).substr(0, needle_.size()) == needle_;
+}
+
+void Search::run(std::shared_ptr<Channel> channel, int from, const CancellationToken& token) {
+    ThreadPool& pool = ThreadPool::getInstance();
+    const int pages = doc_->pages();
+    from = pages > 0 ? std::clamp(from, 0, pages - 1) : 0;
+
+    struct Progress {
+        std::atomic<int> cursor{0};
+        std::atomic<int> jobs;
+        std::atomic<std::size_t> total{0};
+    };
+    const int jobs = std::max(1, std::min(pages, static_cast<int>(pool.size())));
+    auto progress = std::make_shared<Progress>();
+    progress->jobs = jobs;
+
+    for (int i = 0; i < jobs; ++i) {
+        pool.post(
+            [self = shared_from_this(), channel, token, progress, pages, from] {
+                for (int k; !token.cancelled() && (k = progress->cursor.fetch_add(1)) < pages;) {
+                    progress->total += self->scan((from + k) % pages, *channel);
+                }
+
+                if (progress->jobs.fetch_sub(1) != 1) {
+                    return;
+                }
+
+                // The occurrences of `base_` are no longer needed, don't keep a chain of searches alive
+                self->base_.reset();
+                if (!token.cancelled()) {
+                    channel->write("(search-done " + std::to_string(progress->total.load()) + ")\n");
+                }
+            },
+            Priority::Normal);
+    }
+}
+
+std::size_t Search::scan(int page, Channel& channel) {
+    // Nothing to do if the base search found no occurrence on the page
+    std::vector<std::uint32_t> found;
+    const bool refining = base_ && base_->scanned(page, found);
+    if (refining && found.empty()) {
+        std::lock_guard<std::mutex> lock(mu_);
+        scanned_[page] = true;
+        return 0;
+    }
+
+    std::shared_ptr<const PageText> t;
+    try {
+        t = doc_->text(page);
+    } catch (const std::exception&) {
+        // A broken page has no matches
+        return 0;
+    }
+
+    std::vector<Match> matches;
+    if (regex_) {
+        matches = regexMatches(*t, folding_, *regex_, needle_);
+    } else {
+        const std::string_view text = t->view(folding_).first;
+        found = refining ? refine(text, found, needle_, false) : occurrences(text, needle_, false);
+        matches = toMatches(*t, folding_, found, needle_.size());
+    }
+    if (!matches.empty()) {
+        std::string msg = "(search-matches " + std::to_string(page) + " (";
+        for (const Match& m : matches) {
+            msg += '(';
+            for (const Box& box : boxesOf(*t, m)) {
+                appendBox(msg, box);
+            }
+            msg += ')';
+        }
+        msg += "))\n";
+        channel.write(msg);
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    occurrences_[page] = std::move(found);
+    scanned_[page] = true;
+    return matches.size();
+}
+
+bool Search::scanned(int page, std::vector<std::uint32_t>& out) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!scanned_[page]) {
+        return false;
+    }
+
+    out = occurrences_[page];
+    return true;
+}
+} // namespace yapdf
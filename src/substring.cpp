@@ -0,0 +1,76 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "substring.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+bool isAlpha(unsigned char c) noexcept {
+    return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+// Letters differ from their other case in bit 5 only
+unsigned char caseBit(unsigned char c, bool foldCase) noexcept {
+    return foldCase && isAlpha(c) ? 0x20 : 0;
+}
+
+bool equalAt(const char* p, std::string_view needle, bool foldCase) noexcept {
+    for (std::size_t i = 0; i < needle.size(); ++i) {
+        const auto a = static_cast<unsigned char>(p[i]);
+        const auto b = static_cast<unsigned char>(needle[i]);
+        const unsigned char bit = caseBit(b, foldCase);
+        if ((a | bit) != (b | bit)) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+namespace yapdf {
+std::size_t findSubstring(std::string_view hay, std::string_view needle, bool foldCase, std::size_t from) noexcept {
+    const std::size_t n = needle.size();
+    if (from > hay.size() || n > hay.size() - from) {
+        return std::string_view::npos;
+    }
+    if (n == 0) {
+        return from;
+    }
+
+    const char* base = hay.data();
+    const std::size_t last = hay.size() - n;
+    std::size_t i = from;
+
+#ifdef __SSE2__
+    const auto head = static_cast<unsigned char>(needle.front());
+    const auto tail = static_cast<unsigned char>(needle.back());
+    const __m128i headBit = _mm_set1_epi8(static_cast<char>(caseBit(head, foldCase)));
+    const __m128i tailBit = _mm_set1_epi8(static_cast<char>(caseBit(tail, foldCase)));
+    const __m128i headByte = _mm_set1_epi8(static_cast<char>(head | caseBit(head, foldCase)));
+    const __m128i tailByte = _mm_set1_epi8(static_cast<char>(tail | caseBit(tail, foldCase)));
+
+    for (; i + 16 <= last + 1; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i + n - 1));
+        const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(a, headBit), headByte),
+                                         _mm_cmpeq_epi8(_mm_or_si128(b, tailBit), tailByte));
+
+        for (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq)); mask != 0; mask &= mask - 1) {
+            const std::size_t at = i + static_cast<std::size_t>(__builtin_ctz(mask));
+            if (equalAt(base + at, needle, foldCase)) {
+                return at;
+            }
+        }
+    }
+#endif
+
+    for (; i <= last; ++i) {
+        if (equalAt(base + i, needle, foldCase)) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+} // namespace yapdf
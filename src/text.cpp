@@ -0,0 +1,80 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "text.hpp"
+
+#include "unicode.hpp"
+
+#include <poppler/cpp/poppler-page.h>
+
+namespace {
+// poppler reports no line structure, words overlapping vertically are taken as on the same line
+bool sameLine(const poppler::rectf& a, const poppler::rectf& b) {
+    return a.top() < b.bottom() && b.top() < a.bottom();
+}
+} // namespace
+
+namespace yapdf {
+PageText PageText::extract(const poppler::page& page) {
+    const std::vector<poppler::text_box> words = page.text_list();
+
+    PageText t;
+    for (std::size_t w = 0; w < words.size(); ++w) {
+        const poppler::text_box& word = words[w];
+        const poppler::ustring s = word.text();
+
+        // `s` is UTF-16, while poppler keeps a box per code point
+        std::size_t glyph = 0;
+        for (std::size_t i = 0; i < s.size(); ++i, ++glyph) {
+            char32_t c = s[i];
+            if (c >= 0xd800 && c < 0xdc00 && i + 1 < s.size() && s[i + 1] >= 0xdc00 && s[i + 1] < 0xe000) {
+                c = 0x10000 + ((c - 0xd800) << 10) + (s[i + 1] - 0xdc00);
+                ++i;
+            }
+
+            const poppler::rectf box = word.char_bbox(glyph);
+            t.offsets.push_back(static_cast<std::uint32_t>(t.text.size()));
+            t.x0.push_back(static_cast<float>(box.left()));
+            t.y0.push_back(static_cast<float>(box.top()));
+            t.x1.push_back(static_cast<float>(box.right()));
+            t.y1.push_back(static_cast<float>(box.bottom()));
+            appendUtf8(t.text, c);
+        }
+
+        if (w + 1 < words.size()) {
+            if (!sameLine(word.bbox(), words[w + 1].bbox())) {
+                t.text.push_back('\n');
+            } else if (word.has_space_after()) {
+                t.text.push_back(' ');
+            }
+        }
+    }
+    return t;
+}
+
+std::pair<std::string_view, const std::vector<std::uint32_t>&> PageText::view(Folding f) const {
+    if (f == Folding::None) {
+        return {text, offsets};
+    }
+
+    const bool strip = f == Folding::Diacritics;
+    FoldedText& out = strip ? folds_->bare : folds_->folded;
+    std::call_once(strip ? folds_->bareOnce : folds_->caseOnce, [this, &out, strip] { fold(out, strip); });
+    return {out.text, out.offsets};
+}
+
+void PageText::fold(FoldedText& out, bool strip) const {
+    out.offsets.reserve(offsets.size());
+
+    // Glyphs are single code points, and the bytes between them are ASCII separators, folded as is
+    std::size_t byte = 0;
+    for (std::uint32_t start : offsets) {
+        out.text.append(text, byte, start - byte);
+        out.offsets.push_back(static_cast<std::uint32_t>(out.text.size()));
+
+        const char* p = text.data() + start;
+        foldCodePoint(decodeUtf8(p, text.data() + text.size()), strip, out.text);
+        byte = static_cast<std::size_t>(p - text.data());
+    }
+    out.text.append(text, byte, std::string::npos);
+}
+} // namespace yapdf
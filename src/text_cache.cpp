@@ -0,0 +1,78 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "text_cache.hpp"
+
+#include <utility>
+
+namespace {
+// Attach `value` to the slot of `entry` if its text is still `text` and the slot is empty, and return the attached one
+template <typename T>
+std::shared_ptr<const T> attach(yapdf::TextCache::Entry& entry, std::shared_ptr<const T> yapdf::TextCache::Entry::*slot,
+                                const std::shared_ptr<const yapdf::PageText>& text, std::shared_ptr<const T> value) {
+    if (entry.text != text) {
+        return value;
+    }
+    if (!(entry.*slot)) {
+        entry.*slot = std::move(value);
+    }
+    return entry.*slot;
+}
+} // namespace
+
+namespace yapdf {
+TextCache::TextCache(int pages, std::size_t capacity)
+    : capacity_(capacity), entries_(pages), pos_(pages, lru_.end()) {}
+
+TextCache::Entry TextCache::find(int page) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (entries_[page].text) {
+        touch(page);
+    }
+    return entries_[page];
+}
+
+std::shared_ptr<const PageText> TextCache::insert(int page, std::shared_ptr<const PageText> text) {
+    std::lock_guard<std::mutex> lock(mu_);
+    Entry& entry = entries_[page];
+    if (entry.text) {
+        touch(page);
+        return entry.text;
+    }
+
+    used_ += text->bytes();
+    entry.text = std::move(text);
+    lru_.push_front(page);
+    pos_[page] = lru_.begin();
+
+    // Keep at least the newest page even if it's over budget
+    while (used_ > capacity_ && lru_.size() > 1) {
+        const int victim = lru_.back();
+        used_ -= entries_[victim].text->bytes();
+        entries_[victim] = Entry{};
+        pos_[victim] = lru_.end();
+        lru_.pop_back();
+    }
+    return entries_[page].text;
+}
+
+std::shared_ptr<const GlyphIndex> TextCache::insert(int page, const std::shared_ptr<const PageText>& text,
+                                                    std::shared_ptr<const GlyphIndex> glyphs) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return attach(entries_[page], &Entry::glyphs, text, std::move(glyphs));
+}
+
+std::shared_ptr<const LinkMap> TextCache::insert(int page, const std::shared_ptr<const PageText>& text,
+                                                 std::shared_ptr<const LinkMap> links) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return attach(entries_[page], &Entry::links, text, std::move(links));
+}
+
+std::size_t TextCache::usage() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return used_;
+}
+
+void TextCache::touch(int page) {
+    lru_.splice(lru_.begin(), lru_, pos_[page]);
+}
+} // namespace yapdf
@@ -0,0 +1,371 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "text_index.hpp"
+
+#include "disk_cache.hpp"
+#include "thread_pool.hpp"
+#include "unicode.hpp"
+
+#include <poppler/cpp/poppler-page.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace {
+constexpr char INDEX_MAGIC[8] = {'Y', 'A', 'P', 'D', 'F', 'T', 'X', 'I'};
+constexpr std::uint32_t INDEX_VERSION = 3;
+
+std::mutex directory_mu;
+std::string index_directory;
+
+// Han, kana and Hangul, written without spaces between words
+bool isCjk(char32_t c) noexcept {
+    return (c >= 0x3040 && c <= 0x30ff) || (c >= 0x3400 && c <= 0x4dbf) || (c >= 0x4e00 && c <= 0x9fff) ||
+           (c >= 0xac00 && c <= 0xd7af) || (c >= 0xf900 && c <= 0xfaff) || (c >= 0x20000 && c <= 0x2ffff);
+}
+
+// CJK symbols and punctuation, and the fullwidth forms of ASCII punctuation, separate words like ASCII punctuation
+bool isWordChar(char32_t c) noexcept {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= 0x80 && !(c >= 0x3000 && c <= 0x303f) && !(c >= 0xff00 && c <= 0xff0f) &&
+            !(c >= 0xff1a && c <= 0xff20) && !(c >= 0xff5b && c <= 0xff65));
+}
+
+// Return true if `word` is a single CJK character, which is also the prefix of the bigrams it starts
+bool isCjkUnigram(std::string_view word) noexcept {
+    const char* p = word.data();
+    const char* end = p + word.size();
+    return isCjk(yapdf::decodeUtf8(p, end)) && p == end;
+}
+
+char foldAscii(char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::string indexPath(const std::string& dir, std::uint64_t doc) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%016" PRIx64 ".idx", doc);
+    return dir + name;
+}
+
+} // namespace
+
+namespace yapdf {
+struct TextIndex::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t terms;
+    std::uint64_t doc;
+    std::uint64_t postings;
+    std::uint64_t strings;
+};
+
+struct TextIndex::Term {
+    // The word in the string pool
+    std::uint64_t offset;
+    std::uint32_t length;
+    std::uint32_t reserved;
+    // The postings of the word, sorted by page and position
+    std::uint64_t first;
+    std::uint64_t count;
+};
+
+std::string TextIndex::defaultDirectory() {
+    return DiskCache::defaultDirectory() + "/index";
+}
+
+std::string TextIndex::directory() {
+    std::lock_guard<std::mutex> lock(directory_mu);
+    return index_directory;
+}
+
+void TextIndex::directory(std::string dir) {
+    std::lock_guard<std::mutex> lock(directory_mu);
+    index_directory = std::move(dir);
+}
+
+void TextIndex::tokenize(std::string_view text, const std::function<void(std::string_view, std::size_t)>& f) {
+    const char* const begin = text.data();
+    const char* const end = begin + text.size();
+    const auto emit = [&](const char* first, const char* last) {
+        f(text.substr(first - begin, last - first), static_cast<std::size_t>(first - begin));
+    };
+
+    const char* p = begin;
+    while (p < end) {
+        const char* start = p;
+        const char32_t c = decodeUtf8(p, end);
+        if (isCjk(c)) {
+            // Every character starts a bigram with the next one, or stands alone at the end of the run, so a phrase
+            // of n characters is n consecutive terms
+            const char* next = p;
+            emit(start, p < end && isCjk(decodeUtf8(next, end)) ? next : p);
+            continue;
+        }
+        if (!isWordChar(c)) {
+            continue;
+        }
+
+        for (const char* q = p; p < end; p = q) {
+            const char32_t d = decodeUtf8(q, end);
+            if (!isWordChar(d) || isCjk(d)) {
+                break;
+            }
+        }
+        emit(start, p);
+    }
+}
+
+TextIndex::Postings TextIndex::collect(const Document& doc, int first, int last, const CancellationToken& token) {
+    Postings out;
+    for (int page = first; page < last && !token.cancelled(); ++page) {
+        // Bypass the text cache of `doc`, most pages are never looked at
+        PageText t;
+        try {
+            t = doc.use([page](const poppler::document& d) {
+                const std::unique_ptr<poppler::page> p(d.create_page(page));
+                return p ? PageText::extract(*p) : PageText();
+            });
+        } catch (const std::exception&) {
+            continue;
+        }
+
+        std::uint32_t position = 0;
+        std::string word;
+        TextIndex::tokenize(t.text, [&](std::string_view w, std::size_t offset) {
+            word.assign(w);
+            std::transform(word.begin(), word.end(), word.begin(), foldAscii);
+
+            const auto glyph = std::lower_bound(t.offsets.begin(), t.offsets.end(), offset) - t.offsets.begin();
+            out[word].push_back(TextIndex::Posting{static_cast<std::uint32_t>(page), position++,
+                                                          static_cast<std::uint32_t>(glyph)});
+        });
+    }
+    return out;
+}
+void TextIndex::load(std::shared_ptr<Document> doc, const std::string& dir, const CancellationToken& token) {
+    ThreadPool::getInstance().post(
+        [doc, dir, token] {
+            ThreadPool& pool = ThreadPool::getInstance();
+            const std::uint64_t hash = doc->hash();
+            const std::string path = indexPath(dir, hash);
+            try {
+                doc->index(std::make_shared<const TextIndex>(path, hash));
+                return;
+            } catch (const std::exception&) {
+                // Not built yet, or unusable
+            }
+
+            // Collect the postings of contiguous chunks of pages in parallel, the last chunk done writes the index
+            struct Build {
+                std::vector<Postings> chunks;
+                std::atomic<int> pending;
+            };
+            const int pages = doc->pages();
+            const int jobs = std::max(1, std::min(pages, static_cast<int>(pool.size())));
+            auto build = std::make_shared<Build>();
+            build->chunks.resize(jobs);
+            build->pending = jobs;
+
+            for (int i = 0; i < jobs; ++i) {
+                pool.post(
+                    [doc, path, hash, token, build, pages, jobs, i] {
+                        const int first = static_cast<int>(static_cast<long long>(pages) * i / jobs);
+                        const int last = static_cast<int>(static_cast<long long>(pages) * (i + 1) / jobs);
+                        build->chunks[i] = collect(*doc, first, last, token);
+                        if (build->pending.fetch_sub(1) != 1 || token.cancelled()) {
+                            return;
+                        }
+
+                        try {
+                            write(path, hash, build->chunks);
+                            doc->index(std::make_shared<const TextIndex>(path, hash));
+                        } catch (const std::exception&) {
+                            // The document stays unindexed
+                        }
+                    },
+                    Priority::Low);
+            }
+        },
+        Priority::Low);
+}
+
+TextIndex::TextIndex(const std::string& path, std::uint64_t doc) : file_(path) {
+    const std::size_t size = file_.size();
+    header_ = reinterpret_cast<const Header*>(file_.data());
+    if (size < sizeof(Header) || std::memcmp(header_->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header_->version != INDEX_VERSION) {
+        throw std::runtime_error("Invalid index: " + path);
+    }
+    if (header_->doc != doc) {
+        throw std::runtime_error("Index of another file: " + path);
+    }
+
+    // Bound each count first, so the total can't overflow
+    const std::size_t body = size - sizeof(Header);
+    const bool fits = header_->terms <= body / sizeof(Term) && header_->postings <= body / sizeof(Posting) &&
+                      header_->strings <= body &&
+                      header_->terms * sizeof(Term) + header_->postings * sizeof(Posting) + header_->strings == body;
+    if (!fits) {
+        throw std::runtime_error("Truncated index: " + path);
+    }
+
+    terms_ = reinterpret_cast<const Term*>(header_ + 1);
+    postings_ = reinterpret_cast<const Posting*>(terms_ + header_->terms);
+    strings_ = reinterpret_cast<const char*>(postings_ + header_->postings);
+    for (std::uint32_t i = 0; i < header_->terms; ++i) {
+        const Term& t = terms_[i];
+        if (t.offset > header_->strings || t.length > header_->strings - t.offset || t.first > header_->postings ||
+            t.count > header_->postings - t.first) {
+            throw std::runtime_error("Corrupted index: " + path);
+        }
+    }
+}
+
+std::size_t TextIndex::terms() const noexcept {
+    return header_->terms;
+}
+
+std::vector<TextIndex::Posting> TextIndex::find(std::string_view query) const {
+    const auto before = [](const Posting& a, const Posting& b) {
+        return a.page < b.page || (a.page == b.page && a.position < b.position);
+    };
+
+    std::vector<std::pair<const Posting*, const Posting*>> words;
+    std::deque<std::vector<Posting>> merged;
+    std::string word;
+    tokenize(query, [&](std::string_view w, std::size_t) {
+        word.assign(w);
+        std::transform(word.begin(), word.end(), word.begin(), foldAscii);
+        if (!isCjkUnigram(word)) {
+            words.push_back(postings(word));
+            return;
+        }
+
+        // The last character of a CJK run in the query may be followed by any other in the page
+        std::vector<Posting>& all = merged.emplace_back();
+        const Term* end = terms_ + header_->terms;
+        for (const Term* t = prefixed(word); t != end && text(*t).substr(0, word.size()) == word; ++t) {
+            all.insert(all.end(), postings_ + t->first, postings_ + t->first + t->count);
+        }
+        std::sort(all.begin(), all.end(), before);
+        words.emplace_back(all.data(), all.data() + all.size());
+    });
+
+    std::vector<Posting> out;
+    if (words.empty()) {
+        return out;
+    }
+
+    // Keep the occurrences of the first word followed by the others
+    for (const Posting* p = words[0].first; p != words[0].second; ++p) {
+        bool phrase = true;
+        for (std::size_t k = 1; k < words.size() && phrase; ++k) {
+            const Posting next{p->page, p->position + static_cast<std::uint32_t>(k), 0};
+            const Posting* q = std::lower_bound(words[k].first, words[k].second, next, before);
+            phrase = q != words[k].second && q->page == next.page && q->position == next.position;
+        }
+
+        if (phrase) {
+            out.push_back(*p);
+        }
+    }
+    return out;
+}
+
+std::string_view TextIndex::text(const Term& t) const noexcept {
+    return std::string_view(strings_ + t.offset, t.length);
+}
+
+const TextIndex::Term* TextIndex::prefixed(std::string_view prefix) const noexcept {
+    return std::lower_bound(terms_, terms_ + header_->terms, prefix,
+                            [this](const Term& a, std::string_view b) { return text(a) < b; });
+}
+
+std::pair<const TextIndex::Posting*, const TextIndex::Posting*>
+TextIndex::postings(std::string_view word) const noexcept {
+    const Term* t = prefixed(word);
+    if (t == terms_ + header_->terms || text(*t) != word) {
+        return {nullptr, nullptr};
+    }
+    return {postings_ + t->first, postings_ + t->first + t->count};
+}
+
+void TextIndex::write(const std::string& path, std::uint64_t doc, const std::vector<Postings>& chunks) {
+    std::vector<std::string_view> words;
+    for (const Postings& chunk : chunks) {
+        for (const auto& kv : chunk) {
+            words.push_back(kv.first);
+        }
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    // Chunks cover increasing pages, so concatenating their postings keeps them sorted
+    std::vector<Term> terms;
+    std::vector<Posting> postings;
+    std::string strings;
+    terms.reserve(words.size());
+    for (std::string_view w : words) {
+        Term t{strings.size(), static_cast<std::uint32_t>(w.size()), 0, postings.size(), 0};
+        strings.append(w);
+
+        const std::string key(w);
+        for (const Postings& chunk : chunks) {
+            if (const auto it = chunk.find(key); it != chunk.end()) {
+                postings.insert(postings.end(), it->second.begin(), it->second.end());
+            }
+        }
+        t.count = postings.size() - t.first;
+        terms.push_back(t);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.terms = static_cast<std::uint32_t>(terms.size());
+    header.doc = doc;
+    header.postings = postings.size();
+    header.strings = strings.size();
+
+    const std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    std::filesystem::create_directories(dir);
+
+    // Write to a private file first, so readers never see a partial index
+    char suffix[64];
+    std::snprintf(suffix, sizeof(suffix), ".tmp.%ld.%zu", static_cast<long>(::getpid()),
+                  std::hash<std::thread::id>()(std::this_thread::get_id()));
+    const std::string tmp = path + suffix;
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(terms.data()), terms.size() * sizeof(Term));
+        out.write(reinterpret_cast<const char*>(postings.data()), postings.size() * sizeof(Posting));
+        out.write(strings.data(), strings.size());
+        if (!out.flush()) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("Failed to write " + tmp);
+        }
+    }
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        const int err = errno;
+        std::remove(tmp.c_str());
+        throw std::system_error(err, std::generic_category(), "rename " + tmp);
+    }
+}
+} // namespace yapdf
@@ -0,0 +1,125 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "thread_pool.hpp"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <csignal>
+
+namespace {
+// The pool of the calling worker thread and its index in the pool
+thread_local const yapdf::ThreadPool* current_pool = nullptr;
+thread_local int current_index = -1;
+} // namespace
+
+namespace yapdf {
+struct ThreadPool::Job {
+    explicit Job(std::function<void()> f, Priority prio) noexcept : f(std::move(f)), prio(prio) {}
+
+    std::function<void()> f;
+    // The priority it's queued with. Guarded by `ThreadPool::mu_`
+    Priority prio;
+    // Whether a worker has taken it. Guarded by `ThreadPool::mu_`
+    bool taken = false;
+};
+
+ThreadPool& ThreadPool::getInstance() noexcept {
+    static ThreadPool instance(std::thread::hardware_concurrency());
+    return instance;
+}
+
+ThreadPool::ThreadPool(std::size_t n) {
+    n = std::max<std::size_t>(n, 1);
+    workers_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        workers_.emplace_back([this, i] { run(static_cast<int>(i)); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        for (auto& q : jobs_) {
+            q.clear();
+        }
+    }
+    cv_.notify_all();
+
+    for (std::thread& t : workers_) {
+        t.join();
+    }
+}
+
+int ThreadPool::worker() const noexcept {
+    return current_pool == this ? current_index : -1;
+}
+
+std::shared_ptr<ThreadPool::Job> ThreadPool::post(std::function<void()> f, Priority prio) {
+    auto job = std::make_shared<Job>(std::move(f), prio);
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        jobs_[static_cast<std::size_t>(prio)].push_back(job);
+    }
+    cv_.notify_one();
+    return job;
+}
+
+void ThreadPool::raise(const std::shared_ptr<Job>& job, Priority prio) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (job->taken || job->prio >= prio) {
+        return;
+    }
+
+    // The entry at the old priority becomes stale
+    job->prio = prio;
+    jobs_[static_cast<std::size_t>(prio)].push_back(job);
+}
+
+void ThreadPool::run(int index) {
+    current_pool = this;
+    current_index = index;
+
+    // Jobs write to `Channel`s whose process may be gone, which must fail with EPIPE rather than kill Emacs
+    sigset_t pipe;
+    sigemptyset(&pipe);
+    sigaddset(&pipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe, nullptr);
+
+    const auto pending = [this] {
+        return std::any_of(std::begin(jobs_), std::end(jobs_), [](const auto& q) { return !q.empty(); });
+    };
+
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [&] { return stopping_ || pending(); });
+            if (stopping_) {
+                return;
+            }
+
+            for (std::size_t i = PRIORITIES; i-- > 0 && !job;) {
+                while (!jobs_[i].empty() && !job) {
+                    std::shared_ptr<Job> p = std::move(jobs_[i].front());
+                    jobs_[i].pop_front();
+
+                    // Skip the stale entries of raised jobs
+                    if (!p->taken && static_cast<std::size_t>(p->prio) == i) {
+                        p->taken = true;
+                        job = std::move(p);
+                    }
+                }
+            }
+
+            if (!job) {
+                continue;
+            }
+        }
+
+        std::function<void()> f = std::move(job->f);
+        f();
+    }
+}
+} // namespace yapdf
@@ -0,0 +1,150 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "thumbnails.hpp"
+
+#include "pixel.hpp"
+#include "render.hpp"
+#include "thread_pool.hpp"
+
+#include <poppler/cpp/poppler-page.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace yapdf {
+Thumbnails::Thumbnails(std::shared_ptr<Document> doc, int size)
+    : doc_(std::move(doc)), size_(checkSize(size)), columns_(THUMBNAIL_SHEET_SIZE / size_),
+      cellsPerSheet_(columns_ * columns_), cells_(doc_->pages()),
+      sheets_((cells_.size() + cellsPerSheet_ - 1) / cellsPerSheet_) {}
+
+int Thumbnails::checkSize(int size) {
+    // At least one cell must fit in a row of a sheet
+    if (size < THUMBNAIL_MIN_SIZE || size > THUMBNAIL_MAX_SIZE) {
+        throw std::out_of_range("Invalid thumbnail size: " + std::to_string(size));
+    }
+    return size;
+}
+
+void Thumbnails::generate(std::shared_ptr<Channel> channel, const CancellationToken& token) {
+    const int pages = doc_->pages();
+    if (pages == 0) {
+        ThreadPool::getInstance().post([channel] { channel->write("(thumbnails-done)\n"); }, Priority::Low);
+        return;
+    }
+
+    // Even ready pages are reported by the jobs: writing from the main thread would block Emacs for good once the
+    // pipe is full, since only Emacs drains it
+    auto remaining = std::make_shared<std::atomic<int>>(pages);
+    for (int i = 0; i < pages; ++i) {
+        ThreadPool::getInstance().post(
+            [self = shared_from_this(), channel, token, remaining, i] {
+                if (token.cancelled()) {
+                    return;
+                }
+
+                Cell cell;
+                try {
+                    cell = self->make(i);
+                } catch (const std::exception&) {
+                    // reported as a failed page
+                }
+
+                const std::string page = std::to_string(i);
+                if (cell.ready) {
+                    channel->write("(thumbnail " + page + " " + std::to_string(cell.width) + " " +
+                                   std::to_string(cell.height) + ")\n");
+                } else {
+                    channel->write("(thumbnail " + page + " nil nil)\n");
+                }
+
+                if (remaining->fetch_sub(1) == 1) {
+                    channel->write("(thumbnails-done)\n");
+                }
+            },
+            Priority::Low);
+    }
+}
+
+std::shared_ptr<Image> Thumbnails::get(int page) const {
+    if (page < 0 || page >= static_cast<int>(cells_.size())) {
+        throw std::out_of_range("No such page: " + std::to_string(page));
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    const Cell& cell = cells_[page];
+    if (!cell.ready) {
+        return nullptr;
+    }
+
+    auto img = std::make_shared<Image>(cell.width, cell.height);
+    const std::uint32_t* in = origin(page);
+    for (int y = 0; y < cell.height; ++y) {
+        std::memcpy(img->row(y), in + static_cast<std::size_t>(THUMBNAIL_SHEET_SIZE) * y,
+                    static_cast<std::size_t>(cell.width) * 4);
+    }
+    return img;
+}
+
+Thumbnails::Cell Thumbnails::make(int page) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (cells_[page].ready) {
+            return cells_[page];
+        }
+    }
+
+    // Render at twice the size to downsample with a 2x2 box filter, which is much sharper than poppler at tiny sizes
+    const double longest = doc_->use([page](const poppler::document& doc) {
+        const std::unique_ptr<poppler::page> p(doc.create_page(page));
+        if (!p) {
+            throw std::runtime_error("Failed to load page " + std::to_string(page));
+        }
+
+        const poppler::rectf box = p->page_rect();
+        return std::max(box.width(), box.height());
+    });
+    if (!(longest > 0)) {
+        return Cell{};
+    }
+
+    const std::shared_ptr<Image> big = rasterizePage(*doc_, page, 2.0 * size_ / longest);
+    const int width = std::min(size_, big->width() / 2);
+    const int height = std::min(size_, big->height() / 2);
+    if (width == 0 || height == 0) {
+        return Cell{};
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    Cell& cell = cells_[page];
+    if (cell.ready) {
+        // Made by a concurrent `generate`
+        return cell;
+    }
+
+    std::unique_ptr<Image>& sheet = sheets_[page / cellsPerSheet_];
+    if (!sheet) {
+        // The last sheet only spans the rows it uses
+        const int first = page / cellsPerSheet_ * cellsPerSheet_;
+        const int cells = std::min(cellsPerSheet_, static_cast<int>(cells_.size()) - first);
+        sheet = std::make_unique<Image>(THUMBNAIL_SHEET_SIZE, (cells + columns_ - 1) / columns_ * size_);
+    }
+
+    std::uint32_t* out = origin(page);
+    for (int y = 0; y < height; ++y) {
+        boxHalve(big->row(2 * y), big->row(2 * y + 1), out + static_cast<std::size_t>(THUMBNAIL_SHEET_SIZE) * y,
+                 width);
+    }
+
+    cell = Cell{true, width, height};
+    return cell;
+}
+
+std::uint32_t* Thumbnails::origin(int page) const noexcept {
+    const int i = page % cellsPerSheet_;
+    Image& sheet = *sheets_[page / cellsPerSheet_];
+    return sheet.row(i / columns_ * size_) + i % columns_ * size_;
+}
+} // namespace yapdf
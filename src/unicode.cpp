@@ -0,0 +1,174 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "unicode.hpp"
+
+namespace {
+// The base letters of U+00C0 to U+017F in lower case, '.' if there's none
+constexpr std::string_view LATIN_BASE = "aaaaaa.ceeeeiiiidnooooo.ouuuuy.."
+                                        "aaaaaa.ceeeeiiiidnooooo.ouuuuy.y"
+                                        "aaaaaaccccccccddddeeeeeeeeeegggg"
+                                        "gggghhhhiiiiiiiiii..jjkk.lllllll"
+                                        "lllnnnnnn...oooooo..rrrrrrssssss"
+                                        "ssttttttuuuuuuuuuuuuwwyyyzzzzzz.";
+
+char32_t lower(char32_t c) noexcept {
+    if ((c >= 'A' && c <= 'Z') || (c >= 0xc0 && c <= 0xde && c != 0xd7)) {
+        return c + 0x20;
+    }
+
+    if (c >= 0x100 && c <= 0x17f) {
+        // Latin Extended-A pairs upper and lower case, on even code points except in two ranges
+        if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17e)) {
+            return c % 2 == 1 ? c + 1 : c;
+        }
+        switch (c) {
+        case 0x130: // İ
+            return 'i';
+        case 0x178: // Ÿ
+            return 0xff;
+        case 0x17f: // ſ
+            return 's';
+        default:
+            break;
+        }
+        if ((c <= 0x137 || (c >= 0x14a && c <= 0x177)) && c % 2 == 0) {
+            return c + 1;
+        }
+        return c;
+    }
+
+    // Greek and Cyrillic
+    if ((c >= 0x391 && c <= 0x3a9 && c != 0x3a2) || (c >= 0x410 && c <= 0x42f)) {
+        return c + 0x20;
+    }
+    if (c == 0x3c2) { // final sigma
+        return 0x3c3;
+    }
+    if (c >= 0x400 && c <= 0x40f) {
+        return c + 0x50;
+    }
+    return c;
+}
+} // namespace
+
+namespace yapdf {
+void appendUtf8(std::string& s, char32_t c) {
+    if (c < 0x80) {
+        s.push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        s.push_back(static_cast<char>(0xc0 | (c >> 6)));
+        s.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else if (c < 0x10000) {
+        s.push_back(static_cast<char>(0xe0 | (c >> 12)));
+        s.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+        s.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else {
+        s.push_back(static_cast<char>(0xf0 | (c >> 18)));
+        s.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3f)));
+        s.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+        s.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    }
+}
+
+char32_t decodeUtf8(const char*& p, const char* end) noexcept {
+    const auto b = static_cast<unsigned char>(*p++);
+    const int n = b >= 0xf0 ? 3 : b >= 0xe0 ? 2 : b >= 0xc0 ? 1 : 0;
+    if (n == 0 || end - p < n) {
+        return b;
+    }
+
+    char32_t c = b & (0x3f >> n);
+    for (int i = 0; i < n; ++i) {
+        const auto cont = static_cast<unsigned char>(p[i]);
+        if ((cont & 0xc0) != 0x80) {
+            return b;
+        }
+        c = (c << 6) | (cont & 0x3f);
+    }
+    p += n;
+    return c;
+}
+
+void foldCodePoint(char32_t c, bool strip, std::string& s) {
+    switch (c) {
+    case 0xad: // soft hyphen
+        return;
+    case 0xa0: // no-break space
+        s.push_back(' ');
+        return;
+    case 0xdf: // ß
+    case 0x1e9e:
+        s += "ss";
+        return;
+    case 0x132: // Ĳ
+    case 0x133:
+        s += "ij";
+        return;
+    case 0x2010: // hyphen
+    case 0x2011: // non-breaking hyphen
+        s.push_back('-');
+        return;
+    case 0x2018: // typographic quotes
+    case 0x2019:
+        s.push_back('\'');
+        return;
+    case 0x201c:
+    case 0x201d:
+        s.push_back('"');
+        return;
+    case 0xfb00:
+        s += "ff";
+        return;
+    case 0xfb01:
+        s += "fi";
+        return;
+    case 0xfb02:
+        s += "fl";
+        return;
+    case 0xfb03:
+        s += "ffi";
+        return;
+    case 0xfb04:
+        s += "ffl";
+        return;
+    case 0xfb05:
+    case 0xfb06:
+        s += "st";
+        return;
+    default:
+        break;
+    }
+
+    if (c >= 0x2000 && c <= 0x200a) { // typographic spaces
+        s.push_back(' ');
+        return;
+    }
+    if (c >= 0xff01 && c <= 0xff5e) { // fullwidth ASCII
+        c -= 0xff01 - 0x21;
+    }
+
+    c = lower(c);
+    if (strip) {
+        if (c >= 0x300 && c <= 0x36f) { // combining marks
+            return;
+        }
+        if (c == 0xe6 || c == 0x153) { // æ, œ
+            s += c == 0xe6 ? "ae" : "oe";
+            return;
+        }
+        if (c >= 0xc0 && c <= 0x17f && LATIN_BASE[c - 0xc0] != '.') {
+            c = static_cast<unsigned char>(LATIN_BASE[c - 0xc0]);
+        }
+    }
+    appendUtf8(s, c);
+}
+
+std::string foldString(std::string_view s, bool strip) {
+    std::string out;
+    out.reserve(s.size());
+    for (const char *p = s.data(), *end = s.data() + s.size(); p < end;) {
+        foldCodePoint(decodeUtf8(p, end), strip, out);
+    }
+    return out;
+}
+} // namespace yapdf
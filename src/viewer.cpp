@@ -1,5 +1,714 @@
+//! SPDX-License-Identifier: GPL-2.0-or-later
+
 #include "viewer.hpp"
 
+#include "await.hpp"
+#include "bridge.hpp"
+#include "buffer_pool.hpp"
+#include "channel.hpp"
+#include "disk_cache.hpp"
+#include "glyph_index.hpp"
+#include "layout.hpp"
+#include "links.hpp"
+#include "pixel.hpp"
+#include "text_index.hpp"
+#include "thread_pool.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+// Encode `img` as a binary PPM, which Emacs displays without any image library
+std::string toPpm(const yapdf::Image& img) {
+    std::string s = "P6\n" + std::to_string(img.width()) + " " + std::to_string(img.height()) + "\n255\n";
+    const std::size_t header = s.size();
+    s.resize(header + static_cast<std::size_t>(img.width()) * img.height() * 3);
+
+    auto* out = reinterpret_cast<std::uint8_t*>(&s[header]);
+    for (int y = 0; y < img.height(); ++y) {
+        yapdf::toRgb24(img.row(y), out + static_cast<std::size_t>(img.width()) * 3 * y, img.width());
+    }
+    return s;
+}
+
+// A private file next to `path`, removed unless it's renamed over `path`
+class TempFile {
+public:
+    explicit TempFile(const std::string& path) : path_(path), tmp_(path + ".tmp." + std::to_string(::getpid())) {}
+
+    ~TempFile() {
+        if (!tmp_.empty()) {
+            std::remove(tmp_.c_str());
+        }
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    [[nodiscard]] const std::string& path() const noexcept {
+        return tmp_;
+    }
+
+    // Replace the file at the final path
+    void commit() {
+        if (std::rename(tmp_.c_str(), path_.c_str()) != 0) {
+            throw std::system_error(errno, std::generic_category(), "rename " + tmp_);
+        }
+        tmp_.clear();
+    }
+
+private:
+    std::string path_;
+    std::string tmp_;
+};
+
+// Extract the text of `doc` in contiguous chunks of pages, one job per worker
+std::vector<std::future<std::string>> extractText(const std::shared_ptr<yapdf::Document>& doc,
+                                                  const yapdf::CancellationToken& token) {
+    yapdf::ThreadPool& pool = yapdf::ThreadPool::getInstance();
+    const int pages = doc->pages();
+    const int jobs = std::max(1, std::min(pages, static_cast<int>(pool.size())));
+
+    std::vector<std::future<std::string>> futs;
+    futs.reserve(jobs);
+    for (int i = 0; i < jobs; ++i) {
+        const int first = static_cast<int>(static_cast<long long>(pages) * i / jobs);
+        const int last = static_cast<int>(static_cast<long long>(pages) * (i + 1) / jobs);
+        futs.push_back(pool.submit([doc, first, last, token] { return doc->text(first, last, token); }));
+    }
+    return futs;
+}
+} // namespace
+
 namespace yapdf {
+namespace {
+// Return a channel streaming to the pipe `process`. Only Emacs 28 lets other threads write to a process.
+Expected<std::shared_ptr<Channel>, emacs::Error> channelTo([[maybe_unused]] emacs::Env& e,
+                                                            [[maybe_unused]] emacs::Value process) {
+#if EMACS_MAJOR_VERSION >= 28
+    const int fd = YAPDF_TRY(e.openChannel(process));
+    return std::make_shared<Channel>(fd);
+#else
+    throw std::runtime_error("Streaming to a process requires Emacs 28 or later");
+#endif
+}
+
+// Return `(PPM . RATIO)`, `img` as PPM data to be displayed at RATIO times its size
+Expected<emacs::Value, emacs::Error> zoomed(emacs::Env& e, const Image& img, double ratio) {
+    const emacs::Value data = YAPDF_TRY(e.make<emacs::Value::Type::ByteString>(toPpm(img)));
+    return e.call("cons", data, ratio);
+}
+} // namespace
+
+Expected<emacs::Value, emacs::Error> yapdfOpen(emacs::Env& e, std::string path) {
+    // Parsing a large file takes a while, a quit leaves the job running and drops the document
+    std::future<std::shared_ptr<Document>> fut =
+        ThreadPool::getInstance().submit([path] { return std::make_shared<Document>(path); }, Priority::High);
+    YAPDF_TRY(emacs::await(e, fut));
+
+    auto viewer = std::make_unique<Viewer>(fut.get());
+    if (const std::string dir = TextIndex::directory(); !dir.empty()) {
+        TextIndex::load(viewer->document(), dir, viewer->indexing());
+    }
+    Layout::scan(viewer->document(), viewer->scanning());
+    const emacs::Value ptr = YAPDF_TRY(
+        e.make<emacs::Value::Type::UserPtr>(viewer.get(), [](void* p) EMACS_NOEXCEPT { delete (Viewer*)p; }));
+    // Owned by Emacs from now on
+    static_cast<void>(viewer.release());
+    return ptr;
+}
+YAPDF_EMACS_DEFUN(yapdfOpen, "yapdf--open", "Open the PDF file PATH.\n\nIt can be interrupted by C-g.");
+
+int yapdfPages(emacs::Env&, void* p) {
+    auto* viewer = (Viewer*)p;
+    return viewer->document()->pages();
+}
+YAPDF_EMACS_DEFUN(yapdfPages, "yapdf--pages", "Return the number of pages of the document.");
+
+Expected<emacs::Value, emacs::Error> yapdfText(emacs::Env& e, void* p) {
+    auto* viewer = (Viewer*)p;
+    const CancellationToken token;
+    std::vector<std::future<std::string>> futs = extractText(viewer->document(), token);
+
+    std::string text;
+    for (std::size_t i = 0; i < futs.size(); ++i) {
+        YAPDF_TRY(emacs::await(e, futs[i], token));
+        if (i > 0) {
+            text.push_back('\f');
+        }
+        text += futs[i].get();
+    }
+    return e.make<emacs::Value::Type::String>(text);
+}
+YAPDF_EMACS_DEFUN(yapdfText, "yapdf--text",
+                  "Return the text of the whole document.\n\nPages are separated by a form feed. It can be "
+                  "interrupted by C-g.");
+
+Expected<emacs::Value, emacs::Error> yapdfPageText(emacs::Env& e, void* p, int page) {
+    auto* viewer = (Viewer*)p;
+    std::future<std::shared_ptr<const PageText>> fut =
+        ThreadPool::getInstance().submit([doc = viewer->document(), page] { return doc->text(page); }, Priority::High);
+    YAPDF_TRY(emacs::await(e, fut));
+    const std::shared_ptr<const PageText> t = fut.get();
+
+    // Lisp indexes strings by characters rather than bytes
+    emacs::Value offsets = YAPDF_TRY(e.call("make-vector", t->glyphs(), 0));
+    std::size_t chars = 0;
+    std::size_t byte = 0;
+    for (std::size_t i = 0; i < t->glyphs(); ++i) {
+        for (; byte < t->offsets[i]; ++byte) {
+            chars += (static_cast<unsigned char>(t->text[byte]) & 0xc0) != 0x80;
+        }
+        offsets[i] = YAPDF_TRY(e.make<emacs::Value::Type::Int>(chars));
+    }
+    return e.call("cons", t->text, offsets);
+}
+YAPDF_EMACS_DEFUN(yapdfPageText, "yapdf--page-text",
+                  "Return the text of the 0-based PAGE as (TEXT . OFFSETS).\n\nOFFSETS is a vector holding the "
+                  "position in TEXT of every glyph of the page.");
+
+namespace {
+// Return the glyph index of `page`, built on a worker on first use so that it can be interrupted by C-g
+Expected<std::shared_ptr<const GlyphIndex>, emacs::Error> glyphsOf(emacs::Env& e, const std::shared_ptr<Document>& doc,
+                                                                   int page) {
+    std::future<std::shared_ptr<const GlyphIndex>> fut =
+        ThreadPool::getInstance().submit([doc, page] { return doc->glyphs(page); }, Priority::High);
+    YAPDF_TRY(emacs::await(e, fut));
+    return fut.get();
+}
+} // namespace
+
+Expected<emacs::Value, emacs::Error> yapdfGlyphAt(emacs::Env& e, void* p, int page, double x, double y) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<const GlyphIndex> glyphs = YAPDF_TRY(glyphsOf(e, viewer->document(), page));
+    if (const int i = glyphs->at(static_cast<float>(x), static_cast<float>(y)); i >= 0) {
+        return e.make<emacs::Value::Type::Int>(i);
+    }
+    return e.intern("nil");
+}
+YAPDF_EMACS_DEFUN(yapdfGlyphAt, "yapdf--glyph-at",
+                  "Return the glyph of the 0-based PAGE at X, Y in points, or nil if there's none.\n\nSee "
+                  "`yapdf--page-text' for the text of the glyphs.");
+
+Expected<emacs::Value, emacs::Error> yapdfWordAt(emacs::Env& e, void* p, int page, double x, double y) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<const GlyphIndex> glyphs = YAPDF_TRY(glyphsOf(e, viewer->document(), page));
+    if (const int i = glyphs->at(static_cast<float>(x), static_cast<float>(y)); i >= 0) {
+        const auto [first, last] = glyphs->word(static_cast<std::uint32_t>(i));
+        return e.call("cons", first, last);
+    }
+    return e.intern("nil");
+}
+YAPDF_EMACS_DEFUN(yapdfWordAt, "yapdf--word-at",
+                  "Return the word of the 0-based PAGE at X, Y in points as glyphs (FIRST . LAST), or nil.\n\nLAST "
+                  "is exclusive.");
+
+Expected<emacs::Value, emacs::Error> yapdfSelect(emacs::Env& e, void* p, int page, double x0, double y0, double x1,
+                                                 double y1, bool rectangle) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<const GlyphIndex> glyphs = YAPDF_TRY(glyphsOf(e, viewer->document(), page));
+
+    // Runs of consecutive glyphs
+    std::vector<Match> runs;
+    if (rectangle) {
+        const Box box{static_cast<float>(x0), static_cast<float>(y0), static_cast<float>(x1), static_cast<float>(y1)};
+        for (std::uint32_t i : glyphs->within(box)) {
+            if (runs.empty() || runs.back().last != i) {
+                runs.push_back(Match{i, i + 1});
+            } else {
+                ++runs.back().last;
+            }
+        }
+    } else {
+        const int a = glyphs->nearest(static_cast<float>(x0), static_cast<float>(y0));
+        const int b = glyphs->nearest(static_cast<float>(x1), static_cast<float>(y1));
+        if (a >= 0) {
+            runs.push_back(
+                Match{static_cast<std::uint32_t>(std::min(a, b)), static_cast<std::uint32_t>(std::max(a, b)) + 1});
+        }
+    }
+
+    emacs::Value out = YAPDF_TRY(e.call("make-vector", runs.size(), e.intern("nil")));
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        const std::vector<Box> lines = boxesOf(glyphs->text(), runs[i]);
+        emacs::Value boxes = YAPDF_TRY(e.call("make-vector", lines.size(), e.intern("nil")));
+        for (std::size_t k = 0; k < lines.size(); ++k) {
+            const Box& b = lines[k];
+            boxes[k] = YAPDF_TRY(e.call("list", static_cast<double>(b.x0), static_cast<double>(b.y0),
+                                        static_cast<double>(b.x1), static_cast<double>(b.y1)));
+        }
+        out[i] = YAPDF_TRY(e.call("cons", runs[i].first, YAPDF_TRY(e.call("cons", runs[i].last, boxes))));
+    }
+    return out;
+}
+YAPDF_EMACS_DEFUN(yapdfSelect, "yapdf--select",
+                  "Return the glyphs of the 0-based PAGE selected from X0, Y0 to X1, Y1 in points.\n\nThe "
+                  "selection runs in reading order between the glyphs nearest to both points, or covers the glyphs "
+                  "inside the rectangle if RECTANGLE is non-nil. Return a vector of (FIRST LAST . BOXES), one per "
+                  "run of consecutive glyphs from FIRST up to LAST exclusive, where BOXES is a vector of (X0 Y0 X1 "
+                  "Y1) covering the run, one per line.");
+
+Expected<emacs::Value, emacs::Error> yapdfLinkAt(emacs::Env& e, void* p, int page, double x, double y) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<Document>& doc = viewer->document();
+    std::future<std::pair<std::shared_ptr<const GlyphIndex>, std::shared_ptr<const LinkMap>>> fut =
+        ThreadPool::getInstance().submit([doc, page] { return std::make_pair(doc->glyphs(page), doc->links(page)); },
+                                         Priority::High);
+    YAPDF_TRY(emacs::await(e, fut));
+    const auto [glyphs, links] = fut.get();
+
+    const int i = glyphs->at(static_cast<float>(x), static_cast<float>(y));
+    const Link* link = i >= 0 ? links->at(static_cast<std::uint32_t>(i)) : nullptr;
+    if (!link) {
+        return e.intern("nil");
+    }
+    return e.make<emacs::Value::Type::String>(link->uri);
+}
+YAPDF_EMACS_DEFUN(yapdfLinkAt, "yapdf--link-at",
+                  "Return the target URI of the link of the 0-based PAGE at X, Y in points, or nil.\n\nOnly URIs "
+                  "spelled out in the page text are links, links inside the document aren't supported.");
+
+Expected<emacs::Value, emacs::Error> yapdfLinks(emacs::Env& e, void* p, int page) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<Document>& doc = viewer->document();
+    std::future<std::shared_ptr<const LinkMap>> fut =
+        ThreadPool::getInstance().submit([doc, page] { return doc->links(page); }, Priority::High);
+    YAPDF_TRY(emacs::await(e, fut));
+    const std::shared_ptr<const LinkMap> links = fut.get();
+    const std::shared_ptr<const PageText> t = doc->text(page);
+
+    emacs::Value out = YAPDF_TRY(e.call("make-vector", links->links().size(), e.intern("nil")));
+    for (std::size_t i = 0; i < links->links().size(); ++i) {
+        const Link& link = links->links()[i];
+        const std::vector<Box> lines = boxesOf(*t, Match{link.first, link.last});
+        emacs::Value boxes = YAPDF_TRY(e.call("make-vector", lines.size(), e.intern("nil")));
+        for (std::size_t k = 0; k < lines.size(); ++k) {
+            const Box& b = lines[k];
+            boxes[k] = YAPDF_TRY(e.call("list", static_cast<double>(b.x0), static_cast<double>(b.y0),
+                                        static_cast<double>(b.x1), static_cast<double>(b.y1)));
+        }
+        const emacs::Value target = YAPDF_TRY(e.make<emacs::Value::Type::String>(link.uri));
+        out[i] = YAPDF_TRY(e.call("cons", target, boxes));
+    }
+    return out;
+}
+YAPDF_EMACS_DEFUN(yapdfLinks, "yapdf--links",
+                  "Return the links of the 0-based PAGE as a vector of (URI . BOXES).\n\nBOXES is a vector of (X0 "
+                  "Y0 X1 Y1) in points, one per line. See `yapdf--link-at'.");
+
+Expected<emacs::Value, emacs::Error> yapdfOutline(emacs::Env& e, void* p, int item, int depth) {
+    auto* viewer = (Viewer*)p;
+    if (!viewer->outline()) {
+        std::future<std::shared_ptr<const Outline>> fut = ThreadPool::getInstance().submit(
+            [doc = viewer->document()] {
+                return std::make_shared<const Outline>(
+                    doc->use([](const poppler::document& d) { return Outline::extract(d); }));
+            },
+            Priority::High);
+        YAPDF_TRY(emacs::await(e, fut));
+        viewer->outline(fut.get());
+    }
+
+    const std::vector<OutlineItem>& items = viewer->outline()->items();
+    const std::vector<std::uint32_t> subtree = viewer->outline()->subtree(item, depth);
+    const emacs::Value nil = YAPDF_TRY(e.intern("nil"));
+    const emacs::Value t = YAPDF_TRY(e.intern("t"));
+    // One flat vector rather than a Lisp call per entry, a level can have thousands
+    constexpr std::size_t SLOTS = 5;
+    emacs::Value out = YAPDF_TRY(e.call("make-vector", subtree.size() * SLOTS, nil));
+    for (std::size_t i = 0; i < subtree.size(); ++i) {
+        const OutlineItem& it = items[subtree[i]];
+        out[i * SLOTS] = YAPDF_TRY(e.make<emacs::Value::Type::Int>(subtree[i]));
+        out[i * SLOTS + 1] = YAPDF_TRY(e.make<emacs::Value::Type::String>(it.title));
+        out[i * SLOTS + 2] = YAPDF_TRY(e.make<emacs::Value::Type::Int>(it.depth));
+        out[i * SLOTS + 3] = it.open ? t : nil;
+        out[i * SLOTS + 4] = it.end > subtree[i] + 1 ? t : nil;
+    }
+    return out;
+}
+YAPDF_EMACS_DEFUN(yapdfOutline, "yapdf--outline",
+                  "Return the outline entries below ITEM, at most DEPTH levels deep.\n\nITEM is the index of an "
+                  "entry, or -1 for the top level. The outline is read on first use, which can be interrupted by "
+                  "C-g. Return a flat vector of INDEX TITLE DEPTH OPEN CHILDREN, five slots per entry in preorder, "
+                  "where DEPTH is 0 at the top level, OPEN is non-nil if the entry is expanded initially, and "
+                  "CHILDREN is non-nil if it has children, which can be fetched with their INDEX. Target pages "
+                  "aren't known, poppler-cpp doesn't expose them.");
+
+Expected<emacs::Value, emacs::Error> yapdfLayoutExtent(emacs::Env& e, void* p, double scale, double gap) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<const Layout> layout = viewer->layout();
+    const auto [width, height] = layout->extent(scale, gap);
+    return e.call("cons", width, height);
+}
+YAPDF_EMACS_DEFUN(yapdfLayoutExtent, "yapdf--layout-extent",
+                  "Return the size of all pages laid out vertically as (WIDTH . HEIGHT) in pixels.\n\nPages are "
+                  "rendered at SCALE, with GAP pixels between them.\n\nAll pages are taken to have the size of the "
+                  "first one until their size is read in the background, see `yapdf--layout-exact-p'.");
+
+bool yapdfLayoutExactP(emacs::Env&, void* p) {
+    auto* viewer = (Viewer*)p;
+    return viewer->layout()->exact();
+}
+YAPDF_EMACS_DEFUN(yapdfLayoutExactP, "yapdf--layout-exact-p",
+                  "Return non-nil once the size of every page is read, or every page is cropped if cropping, so the "
+                  "layout no longer changes.");
+
+void yapdfSetCrop(emacs::Env&, void* p, bool enable, int page) {
+    auto* viewer = (Viewer*)p;
+    viewer->crop(enable, page);
+}
+YAPDF_EMACS_DEFUN(yapdfSetCrop, "yapdf--set-crop",
+                  "Lay out pages cropped to their content if ENABLE is non-nil, or at full size otherwise.\n\nThe "
+                  "content of every page is found in the background the first time, starting around the 0-based "
+                  "PAGE. Pages not cropped yet keep their full size, see `yapdf--layout-exact-p'. Draw a page with "
+                  "the slice of `yapdf--content-box'.");
+
+Expected<emacs::Value, emacs::Error> yapdfContentBox(emacs::Env& e, void* p, int page) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<Document>& doc = viewer->document();
+    std::future<Box> fut = ThreadPool::getInstance().submit([doc, page] { return doc->content(page); }, Priority::High);
+    YAPDF_TRY(emacs::await(e, fut));
+    const Box box = fut.get();
+    return e.call("list", static_cast<double>(box.x0), static_cast<double>(box.y0), static_cast<double>(box.x1),
+                  static_cast<double>(box.y1));
+}
+YAPDF_EMACS_DEFUN(yapdfContentBox, "yapdf--content-box",
+                  "Return the content of the 0-based PAGE without its blank margins as (X0 Y0 X1 Y1) in points.\n\n"
+                  "It's found the first time by rendering the page at a low resolution, which can be interrupted by "
+                  "C-g, and cached.");
+
+Expected<emacs::Value, emacs::Error> yapdfPageOffset(emacs::Env& e, void* p, int page, double scale, double gap) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<const Layout> layout = viewer->layout();
+    if (page < 0 || page >= layout->pages()) {
+        throw std::out_of_range("No such page: " + std::to_string(page));
+    }
+    return e.make<emacs::Value::Type::Float>(layout->offset(page, scale, gap));
+}
+YAPDF_EMACS_DEFUN(yapdfPageOffset, "yapdf--page-offset",
+                  "Return the top of the 0-based PAGE in pixels, see `yapdf--layout-extent'.");
+
+Expected<emacs::Value, emacs::Error> yapdfPageAt(emacs::Env& e, void* p, double y, double scale, double gap) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<const Layout> layout = viewer->layout();
+    return e.make<emacs::Value::Type::Int>(layout->pageAt(y, scale, gap));
+}
+YAPDF_EMACS_DEFUN(yapdfPageAt, "yapdf--page-at",
+                  "Return the 0-based page at Y in pixels, see `yapdf--layout-extent'.\n\nA Y in the gap below a "
+                  "page is on that page.");
+
+Expected<emacs::Value, emacs::Error> yapdfVisiblePages(emacs::Env& e, void* p, double top, double height, double scale,
+                                                       double gap) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<const Layout> layout = viewer->layout();
+    const auto [first, last] = layout->visible(top, height, scale, gap);
+    const double width = layout->extent(scale, gap).first;
+
+    emacs::Value out = YAPDF_TRY(e.call("make-vector", last - first, e.intern("nil")));
+    for (int i = first; i < last; ++i) {
+        const PageSize size = layout->size(i);
+        out[i - first] = YAPDF_TRY(e.call("vector", i, (width - size.width * scale) / 2,
+                                          layout->offset(i, scale, gap), size.width * scale, size.height * scale));
+    }
+    return out;
+}
+YAPDF_EMACS_DEFUN(yapdfVisiblePages, "yapdf--visible-pages",
+                  "Return the pages intersecting the HEIGHT pixels from TOP, see `yapdf--layout-extent'.\n\nReturn "
+                  "a vector of [PAGE X Y WIDTH HEIGHT] in pixels, where X centers the page. Only these pages need an "
+                  "image.");
+
+Expected<emacs::Value, emacs::Error> yapdfExportText(emacs::Env& e, void* p, std::string file) {
+    auto* viewer = (Viewer*)p;
+    const CancellationToken token;
+    std::vector<std::future<std::string>> futs = extractText(viewer->document(), token);
+
+    // FILE is only replaced once all the text is written, a quit or an error leaves it as it was
+    TempFile tmp(file);
+    std::ofstream out(tmp.path(), std::ios::binary | std::ios::trunc);
+    for (std::size_t i = 0; i < futs.size(); ++i) {
+        YAPDF_TRY(emacs::await(e, futs[i], token));
+        if (i > 0) {
+            out.put('\f');
+        }
+
+        const std::string text = futs[i].get();
+        if (!out.write(text.data(), text.size())) {
+            token.cancel();
+            throw std::runtime_error("Failed to write " + file);
+        }
+    }
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed to write " + file);
+    }
+    tmp.commit();
+    return e.intern("nil");
+}
+YAPDF_EMACS_DEFUN(yapdfExportText, "yapdf--export-text",
+                  "Write the text of the whole document to FILE.\n\nIt can be interrupted by C-g. FILE is only "
+                  "replaced once all the text is written.");
+
+Expected<emacs::Value, emacs::Error> yapdfRender(emacs::Env& e, void* p, int page, double scale) {
+    auto* viewer = (Viewer*)p;
+    const Renderer::Result fut = viewer->renderer().render(viewer->key(page, scale), Priority::High);
+
+    // A quit leaves the job running, the page is still cached for the next request
+    YAPDF_TRY(emacs::await(e, fut));
+    return e.make<emacs::Value::Type::ByteString>(toPpm(*fut.get()));
+}
+YAPDF_EMACS_DEFUN(yapdfRender, "yapdf--render",
+                  "Render the 0-based PAGE at SCALE, a float where 1.0 is 72 DPI.\n\nReturn the image as PPM data.");
+
+Expected<emacs::Value, emacs::Error> yapdfZoom(emacs::Env& e, void* p, emacs::Value process, int page,
+                                               double scale) {
+    auto* viewer = (Viewer*)p;
+    const RenderKey key = viewer->key(page, scale);
+    if (page < 0 || page >= viewer->document()->pages()) {
+        throw std::out_of_range("No such page: " + std::to_string(page));
+    }
+    if (const std::shared_ptr<const Image> img = viewer->renderer().cached(key)) {
+        viewer->zoom().cancel();
+        return zoomed(e, *img, 1.0);
+    }
+
+    // Up to `MIPMAP_MAX_SCALE`, scales are drawn from the pyramid of the page rather than rendered one by one
+    const bool pyramid = scale <= MIPMAP_MAX_SCALE;
+    std::shared_ptr<const Mipmap> mipmap = pyramid ? viewer->mipmaps()->find(key) : nullptr;
+
+#if EMACS_MAJOR_VERSION < 28
+    // Without a channel to report back on, draw or render in place like `yapdf--render`
+    static_cast<void>(process);
+    if (mipmap) {
+        std::future<std::unique_ptr<Image>> fut = ThreadPool::getInstance().submit(
+            [mipmap = std::move(mipmap), scale] { return mipmap->draw(scale); }, Priority::High);
+        YAPDF_TRY(emacs::await(e, fut));
+        return zoomed(e, *fut.get(), 1.0);
+    }
+    const Renderer::Result fut = viewer->renderer().render(key, Priority::High);
+    YAPDF_TRY(emacs::await(e, fut));
+    return zoomed(e, *fut.get(), 1.0);
+#else
+    // Draw or render once the scale settles, every step of a held zoom key would queue a full render otherwise
+    std::shared_ptr<Channel> channel = YAPDF_TRY(channelTo(e, process));
+    viewer->zoom().call(
+        [renderer = viewer->sharedRenderer(), mipmaps = viewer->mipmaps(), mipmap, channel, key, pyramid] {
+            char msg[64];
+            try {
+                if (mipmap) {
+                    renderer->insert(key, mipmap->draw(key.scale));
+                } else if (pyramid) {
+                    RenderKey base = key;
+                    base.scale = mipmapBase(key.scale);
+                    mipmaps->insert(
+                        std::make_shared<const Mipmap>(base, renderer->render(base, Priority::High).get()));
+                } else {
+                    renderer->render(key, Priority::High).get();
+                }
+                std::snprintf(msg, sizeof(msg), "(zoom-ready %d %.17g)\n", key.page, key.scale);
+            } catch (const std::exception&) {
+                std::snprintf(msg, sizeof(msg), "(zoom-ready %d nil)\n", key.page);
+            }
+            channel->write(msg);
+        });
+
+    // Emacs scales the stand-in when it displays it, the main thread doesn't resample a whole page
+    if (mipmap) {
+        const auto [from, level] = mipmap->nearest(scale);
+        return zoomed(e, *level, scale / from);
+    }
+    const auto [near, img] = viewer->renderer().nearest(key);
+    if (!img) {
+        return e.intern("nil");
+    }
+    return zoomed(e, *img, scale / near.scale);
+#endif
+}
+YAPDF_EMACS_DEFUN(yapdfZoom, "yapdf--zoom",
+                  "Return the 0-based PAGE at SCALE without waiting for it to render.\n\nThe result is "
+                  "`(PPM . RATIO)', PPM data to be displayed at RATIO times its size, e.g. with the `:scale' image "
+                  "property. It's the closest level of the pyramid of renderings at powers of two of a page zoomed "
+                  "recently, for SCALE up to 4.0, or else the closest cached scale, or nil if there's none. Once "
+                  "SCALE has been the same for a short while, the page is drawn from the pyramid or rendered. "
+                  "PROCESS is a pipe process, which then receives a line `(zoom-ready PAGE SCALE)', or `(zoom-ready "
+                  "PAGE nil)' if it failed, and `yapdf--zoom' returns the page with a RATIO of 1.0. A zoom still "
+                  "settling is superseded. Before Emacs 28, the page is drawn or rendered at SCALE right away "
+                  "instead.");
+
+void yapdfPrefetch(emacs::Env&, void* p, int page, double scale) {
+    auto* viewer = (Viewer*)p;
+    viewer->renderer().render(viewer->key(page, scale), Priority::Low);
+}
+YAPDF_EMACS_DEFUN(yapdfPrefetch, "yapdf--prefetch",
+                  "Render the 0-based PAGE at SCALE in the background, so that a later `yapdf--render' is fast.");
+
+void yapdfSetColors(emacs::Env&, void* p, std::string mode, int foreground, int background) {
+    static const std::pair<const char*, ColorMode> modes[] = {
+        {"normal", ColorMode::Normal},
+        {"dark", ColorMode::Dark},
+        {"sepia", ColorMode::Sepia},
+        {"colormap", ColorMode::Colormap},
+    };
+
+    auto* viewer = (Viewer*)p;
+    for (const auto& [name, m] : modes) {
+        if (mode == name) {
+            viewer->colors(m, static_cast<std::uint32_t>(foreground) & 0xffffff,
+                           static_cast<std::uint32_t>(background) & 0xffffff);
+            return;
+        }
+    }
+    throw std::invalid_argument("Invalid color mode: " + mode);
+}
+YAPDF_EMACS_DEFUN(yapdfSetColors, "yapdf--set-colors",
+                  "Draw pages in MODE from now on, one of \"normal\", \"dark\", \"sepia\" or \"colormap\".\n\n"
+                  "\"dark\" inverts lightness but keeps hues. \"colormap\" maps black to FOREGROUND and white to "
+                  "BACKGROUND, both integers 0xRRGGBB, which are ignored otherwise. Pages already rendered in MODE "
+                  "are cached, and the others are transformed from their normal rendering without rendering them "
+                  "again if it's cached.");
+
+Expected<emacs::Value, emacs::Error> yapdfThumbnails(emacs::Env& e, void* p, emacs::Value process, int size) {
+    // Before the channel is opened
+    Thumbnails::checkSize(size);
+    auto* viewer = (Viewer*)p;
+    std::shared_ptr<Channel> channel = YAPDF_TRY(channelTo(e, process));
+    viewer->thumbnails(size)->generate(std::move(channel), viewer->restartThumbnailing());
+    return e.intern("nil");
+}
+YAPDF_EMACS_DEFUN(yapdfThumbnails, "yapdf--thumbnails",
+                  "Render the thumbnails of all pages, fitting in SIZE by SIZE pixels, in the background.\n\nPROCESS "
+                  "is a pipe process, which receives a line `(thumbnail PAGE WIDTH HEIGHT)' for every page as it's "
+                  "done, with nil WIDTH and HEIGHT if the page can't be rendered, then `(thumbnails-done)'. A "
+                  "thumbnailing of the document still running is cancelled. This requires Emacs 28 or later.");
+
+Expected<emacs::Value, emacs::Error> yapdfThumbnail(emacs::Env& e, void* p, int page, int size) {
+    Thumbnails::checkSize(size);
+
+    // Only look up the thumbnails being made, a thumbnailing of another size keeps running
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<Thumbnails>& thumbnails = viewer->thumbnails();
+    if (!thumbnails || thumbnails->size() != size) {
+        return e.intern("nil");
+    }
+
+    const std::shared_ptr<Image> img = thumbnails->get(page);
+    if (!img) {
+        return e.intern("nil");
+    }
+    return e.make<emacs::Value::Type::ByteString>(toPpm(*img));
+}
+YAPDF_EMACS_DEFUN(yapdfThumbnail, "yapdf--thumbnail",
+                  "Return the thumbnail of the 0-based PAGE of SIZE as PPM data, or nil if it isn't done yet.\n\n"
+                  "Thumbnails of SIZE must have been requested by `yapdf--thumbnails' first.");
+
+Expected<emacs::Value, emacs::Error> yapdfSearch(emacs::Env& e, void* p, emacs::Value process, std::string query,
+                                                 bool foldCase, int from, bool regex, bool stripDiacritics) {
+    auto* viewer = (Viewer*)p;
+    const Folding folding = !foldCase ? Folding::None : stripDiacritics ? Folding::Diacritics : Folding::Case;
+    std::shared_ptr<Channel> channel = YAPDF_TRY(channelTo(e, process));
+
+    // Search as you type refines the previous matches instead of scanning the document again
+    const std::shared_ptr<Search>& previous = viewer->search();
+    auto search = previous && previous->refinableTo(query, folding, regex)
+                      ? std::make_shared<Search>(std::shared_ptr<const Search>(previous), std::move(query))
+                      : std::make_shared<Search>(viewer->document(), std::move(query), folding, regex);
+    search->run(std::move(channel), from, viewer->restartSearch(search));
+    return e.intern("nil");
+}
+YAPDF_EMACS_DEFUN(yapdfSearch, "yapdf--search",
+                  "Search all pages for QUERY in the background, starting from the 0-based page FROM.\n\nQUERY is an "
+                  "ECMAScript regular expression if REGEXP is non-nil. If FOLD-CASE is non-nil, case, ligatures and "
+                  "compatibility forms are ignored, and diacritics too if STRIP-DIACRITICS is non-nil (but not by "
+                  "regular expressions). PROCESS is a pipe process, which receives a line `(search-matches PAGE "
+                  "MATCHES)' for every page with matches as it's scanned, then `(search-done TOTAL)'. Every match is "
+                  "a list of boxes (X0 Y0 X1 Y1) in points, one per line. A search still running is cancelled. If "
+                  "QUERY extends the query of the previous search, only the previous matches are checked again. This "
+                  "requires Emacs 28 or later.");
+
+void yapdfCancelSearch(emacs::Env&, void* p) {
+    auto* viewer = (Viewer*)p;
+    viewer->cancelSearch();
+}
+YAPDF_EMACS_DEFUN(yapdfCancelSearch, "yapdf--cancel-search", "Cancel the running `yapdf--search'.");
+
+void yapdfEnableTextIndex(emacs::Env&, std::string dir) {
+    TextIndex::directory(dir.empty() ? TextIndex::defaultDirectory() : std::move(dir));
+}
+YAPDF_EMACS_DEFUN(yapdfEnableTextIndex, "yapdf--enable-text-index",
+                  "Index the text of documents opened from now on in DIR.\n\nAn index is built in the background on "
+                  "first open and reused later. An empty DIR stands for $XDG_CACHE_HOME/yapdf/index, or "
+                  "~/.cache/yapdf/index.");
+
+void yapdfDisableTextIndex(emacs::Env&) {
+    TextIndex::directory(std::string());
+}
+YAPDF_EMACS_DEFUN(yapdfDisableTextIndex, "yapdf--disable-text-index", "Stop indexing documents on open.");
+
+bool yapdfIndexedP(emacs::Env&, void* p) {
+    auto* viewer = (Viewer*)p;
+    return viewer->document()->index() != nullptr;
+}
+YAPDF_EMACS_DEFUN(yapdfIndexedP, "yapdf--indexed-p", "Return non-nil if the text index of the document is ready.");
+
+Expected<emacs::Value, emacs::Error> yapdfIndexSearch(emacs::Env& e, void* p, std::string query) {
+    auto* viewer = (Viewer*)p;
+    const std::shared_ptr<const TextIndex> index = viewer->document()->index();
+    if (!index) {
+        throw std::runtime_error("The text index isn't ready");
+    }
+
+    const std::vector<TextIndex::Posting> found = index->find(query);
+    emacs::Value out = YAPDF_TRY(e.call("make-vector", found.size(), e.intern("nil")));
+    for (std::size_t i = 0; i < found.size(); ++i) {
+        out[i] = YAPDF_TRY(e.call("cons", found[i].page, found[i].glyph));
+    }
+    return out;
+}
+YAPDF_EMACS_DEFUN(yapdfIndexSearch, "yapdf--index-search",
+                  "Look up the words of QUERY as a phrase in the text index.\n\nReturn a vector of (PAGE . GLYPH), "
+                  "the 0-based page and the first glyph of each occurrence, see `yapdf--page-text'. Signal an error "
+                  "if the index isn't ready, see `yapdf--indexed-p'.");
+
+void yapdfEnableDiskCache(emacs::Env&, std::string dir, std::intmax_t capacity) {
+    if (dir.empty()) {
+        dir = DiskCache::defaultDirectory();
+    }
+    if (capacity <= 0) {
+        throw std::range_error("Capacity must be positive");
+    }
+    DiskCache::global(std::make_shared<DiskCache>(dir, static_cast<std::size_t>(capacity)));
+}
+YAPDF_EMACS_DEFUN(yapdfEnableDiskCache, "yapdf--enable-disk-cache",
+                  "Cache rendered pages in DIR, using at most CAPACITY bytes.\n\nAn empty DIR stands for "
+                  "$XDG_CACHE_HOME/yapdf, or ~/.cache/yapdf.");
+
+void yapdfDisableDiskCache(emacs::Env&) {
+    DiskCache::global(nullptr);
+}
+YAPDF_EMACS_DEFUN(yapdfDisableDiskCache, "yapdf--disable-disk-cache", "Stop caching rendered pages on disk.");
+
+void yapdfHugePages(emacs::Env&, bool enable) {
+    BufferPool::getInstance().hugePages(enable);
+}
+YAPDF_EMACS_DEFUN(yapdfHugePages, "yapdf--huge-pages",
+                  "Back the buffers of pages rendered from now on with transparent huge pages if ENABLE is non-nil."
+                  "\n\nIt saves TLB misses when drawing large pages, but may use more memory.");
 
+void yapdfTrimMemory(emacs::Env&) {
+    BufferPool::getInstance().trim();
 }
+YAPDF_EMACS_DEFUN(yapdfTrimMemory, "yapdf--trim-memory",
+                  "Return the idle buffers of rendered pages to the OS.\n\nThe kernel reclaims them on its own when "
+                  "memory runs low, this does it right away, e.g. after killing the last PDF buffer.");
+} // namespace yapdf
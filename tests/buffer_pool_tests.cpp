@@ -0,0 +1,95 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "buffer_pool.hpp"
+#include "image.hpp"
+
+namespace {
+constexpr std::size_t MiB = std::size_t(1) << 20;
+} // namespace
+
+TEST_CASE("sizeClass") {
+    REQUIRE_EQ(yapdf::BufferPool::sizeClass(1000), 1000);
+    REQUIRE_EQ(yapdf::BufferPool::sizeClass(MiB), MiB);
+    REQUIRE_EQ(yapdf::BufferPool::sizeClass(MiB + 1), MiB + (64 << 10));
+    REQUIRE_EQ(yapdf::BufferPool::sizeClass(2 * MiB), 2 * MiB);
+    REQUIRE_EQ(yapdf::BufferPool::sizeClass(30 * MiB + 5), 32 * MiB);
+}
+
+TEST_CASE("reuse") {
+    yapdf::BufferPool pool(64 * MiB);
+
+    std::uint8_t* first = nullptr;
+    {
+        yapdf::BufferPool::Buffer buf = pool.acquire(5 * MiB);
+        first = buf.get();
+        std::memset(first, 0xab, 5 * MiB);
+    }
+    REQUIRE_EQ(pool.idle(), 6 * MiB);
+
+    // The same size class gets the idle buffer back, another class doesn't
+    {
+        yapdf::BufferPool::Buffer same = pool.acquire(5 * MiB + 100);
+        REQUIRE_EQ(same.get(), first);
+        REQUIRE_EQ(pool.idle(), 0);
+
+        yapdf::BufferPool::Buffer other = pool.acquire(9 * MiB);
+        REQUIRE_NE(other.get(), first);
+    }
+    REQUIRE_EQ(pool.idle(), 16 * MiB);
+
+    pool.trim();
+    REQUIRE_EQ(pool.idle(), 0);
+
+    SUBCASE("small") {
+        // Small buffers aren't pooled
+        { yapdf::BufferPool::Buffer buf = pool.acquire(1000); }
+        REQUIRE_EQ(pool.idle(), 0);
+    }
+}
+
+TEST_CASE("alignment") {
+    yapdf::BufferPool pool(64 * MiB);
+    pool.hugePages(true);
+    for (std::size_t bytes : {2 * MiB, 5 * MiB, 30 * MiB + 5}) {
+        yapdf::BufferPool::Buffer buf = pool.acquire(bytes);
+        REQUIRE_EQ(reinterpret_cast<std::uintptr_t>(buf.get()) % yapdf::BUFFER_POOL_HUGE_PAGE, 0);
+        std::memset(buf.get(), 0xab, bytes);
+    }
+
+    // Idle buffers stay aligned
+    yapdf::BufferPool::Buffer reused = pool.acquire(5 * MiB);
+    REQUIRE_EQ(reinterpret_cast<std::uintptr_t>(reused.get()) % yapdf::BUFFER_POOL_HUGE_PAGE, 0);
+}
+
+TEST_CASE("capacity") {
+    yapdf::BufferPool pool(10 * MiB);
+    {
+        yapdf::BufferPool::Buffer a = pool.acquire(4 * MiB);
+        yapdf::BufferPool::Buffer b = pool.acquire(4 * MiB);
+        yapdf::BufferPool::Buffer c = pool.acquire(4 * MiB);
+    }
+    // Only two fit
+    REQUIRE_EQ(pool.idle(), 8 * MiB);
+
+    // Another class evicts them to make room
+    { yapdf::BufferPool::Buffer d = pool.acquire(6 * MiB); }
+    REQUIRE_EQ(pool.idle(), 10 * MiB);
+    { yapdf::BufferPool::Buffer e = pool.acquire(8 * MiB); }
+    REQUIRE_EQ(pool.idle(), 8 * MiB);
+}
+
+TEST_CASE("image") {
+    // Images of the same size share buffers through the global pool
+    const std::uint8_t* data = nullptr;
+    {
+        yapdf::Image img(1000, 1000);
+        data = img.data();
+        img.row(999)[999] = 0xffffffff;
+    }
+    yapdf::Image img(1000, 1000);
+    REQUIRE_EQ(img.data(), data);
+}
@@ -0,0 +1,68 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "compress.hpp"
+
+namespace {
+std::vector<std::uint32_t> roundtrip(const std::vector<std::uint32_t>& px, std::size_t* encoded = nullptr) {
+    std::vector<std::uint8_t> buf;
+    yapdf::compressPixels(px.data(), px.size(), buf);
+    if (encoded) {
+        *encoded = buf.size();
+    }
+
+    std::vector<std::uint32_t> out(px.size());
+    REQUIRE(yapdf::decompressPixels(buf.data(), buf.size(), out.data(), out.size()));
+    return out;
+}
+} // namespace
+
+TEST_CASE("empty") {
+    const std::vector<std::uint32_t> px;
+    REQUIRE_EQ(roundtrip(px), px);
+}
+
+TEST_CASE("runs") {
+    // a white page with a few lines of "text"
+    std::vector<std::uint32_t> px(1000 * 1000, 0xffffffff);
+    for (std::size_t i = 0; i < px.size(); i += 997) {
+        px[i] = 0xff000000;
+    }
+
+    std::size_t encoded = 0;
+    REQUIRE_EQ(roundtrip(px, &encoded), px);
+    REQUIRE_LT(encoded, px.size() * 4 / 20);
+}
+
+TEST_CASE("literals") {
+    std::mt19937 rng(42);
+    std::vector<std::uint32_t> px(12345);
+    for (auto& p : px) {
+        p = rng();
+    }
+    // short runs in between
+    px[100] = px[101] = px[102] = px[103];
+    px[500] = px[501];
+
+    REQUIRE_EQ(roundtrip(px), px);
+}
+
+TEST_CASE("corrupted") {
+    std::vector<std::uint32_t> px(300, 0xffffffff);
+    std::vector<std::uint8_t> buf;
+    yapdf::compressPixels(px.data(), px.size(), buf);
+
+    // too few pixels
+    std::vector<std::uint32_t> out(px.size() + 1);
+    REQUIRE_FALSE(yapdf::decompressPixels(buf.data(), buf.size(), out.data(), out.size()));
+
+    // too many pixels
+    REQUIRE_FALSE(yapdf::decompressPixels(buf.data(), buf.size(), out.data(), px.size() - 1));
+
+    // truncated
+    REQUIRE_FALSE(yapdf::decompressPixels(buf.data(), buf.size() - 1, out.data(), px.size()));
+}
@@ -0,0 +1,68 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "crop.hpp"
+
+namespace {
+// A blank page of `width` by `height` pixels
+yapdf::Image blank(int width, int height) {
+    yapdf::Image img(width, height);
+    for (int y = 0; y < height; ++y) {
+        std::fill(img.row(y), img.row(y) + width, yapdf::CROP_BACKGROUND);
+    }
+    return img;
+}
+} // namespace
+
+TEST_CASE("contentBox") {
+    // A letter page at `CROP_SCALE`
+    yapdf::Image img = blank(306, 396);
+
+    SUBCASE("blank") {
+        const yapdf::Box box = yapdf::contentBox(img, yapdf::CROP_SCALE);
+        REQUIRE_EQ(box.x0, 0);
+        REQUIRE_EQ(box.y0, 0);
+        REQUIRE_EQ(box.x1, 612);
+        REQUIRE_EQ(box.y1, 792);
+    }
+
+    SUBCASE("text") {
+        // Two lines of gray text in the middle
+        std::fill(img.row(100) + 50, img.row(100) + 250, 0xff404040);
+        std::fill(img.row(110) + 60, img.row(110) + 200, 0xff404040);
+
+        const yapdf::Box box = yapdf::contentBox(img, yapdf::CROP_SCALE);
+        REQUIRE_EQ(box.x0, 100 - yapdf::CROP_PADDING);
+        REQUIRE_EQ(box.y0, 200 - yapdf::CROP_PADDING);
+        REQUIRE_EQ(box.x1, 500 + yapdf::CROP_PADDING);
+        REQUIRE_EQ(box.y1, 222 + yapdf::CROP_PADDING);
+    }
+
+    SUBCASE("noise") {
+        // Off-white specks of a scan are paper
+        img.row(5)[5] = 0xfff0f0f0;
+        img.row(300)[20] = 0xffeaeaea;
+        img.row(200)[150] = 0xff000000;
+
+        const yapdf::Box box = yapdf::contentBox(img, yapdf::CROP_SCALE);
+        REQUIRE_EQ(box.x0, 300 - yapdf::CROP_PADDING);
+        REQUIRE_EQ(box.y0, 400 - yapdf::CROP_PADDING);
+        REQUIRE_EQ(box.x1, 302 + yapdf::CROP_PADDING);
+        REQUIRE_EQ(box.y1, 402 + yapdf::CROP_PADDING);
+    }
+
+    SUBCASE("edges") {
+        // The padding is clamped to the page
+        img.row(0)[0] = 0xff000000;
+        img.row(395)[305] = 0xff000000;
+
+        const yapdf::Box box = yapdf::contentBox(img, yapdf::CROP_SCALE);
+        REQUIRE_EQ(box.x0, 0);
+        REQUIRE_EQ(box.y0, 0);
+        REQUIRE_EQ(box.x1, 612);
+        REQUIRE_EQ(box.y1, 792);
+    }
+}
@@ -0,0 +1,59 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "debounce.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+// Far longer than the pauses between calls of a burst, so a busy machine doesn't end a burst early
+constexpr auto DELAY = 500ms;
+
+// Wait up to a few seconds for `calls` to reach `n`
+bool waitFor(const std::atomic<int>& calls, int n) {
+    const auto deadline = std::chrono::steady_clock::now() + 10 * DELAY;
+    while (calls < n && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(10ms);
+    }
+    return calls >= n;
+}
+} // namespace
+
+TEST_CASE("burst") {
+    yapdf::Debouncer debouncer(DELAY);
+    std::atomic<int> calls{0};
+    std::atomic<int> last{0};
+    for (int i = 1; i <= 10; ++i) {
+        debouncer.call([&calls, &last, i] {
+            ++calls;
+            last = i;
+        });
+        std::this_thread::sleep_for(5ms);
+    }
+    REQUIRE_EQ(calls, 0);
+
+    REQUIRE(waitFor(calls, 1));
+    REQUIRE_EQ(last, 10);
+    std::this_thread::sleep_for(2 * DELAY);
+    REQUIRE_EQ(calls, 1);
+}
+
+TEST_CASE("cancel") {
+    std::atomic<int> calls{0};
+    {
+        yapdf::Debouncer debouncer(DELAY);
+        debouncer.call([&calls] { ++calls; });
+        debouncer.cancel();
+        std::this_thread::sleep_for(2 * DELAY);
+        REQUIRE_EQ(calls, 0);
+
+        // Dropped with the debouncer
+        debouncer.call([&calls] { ++calls; });
+    }
+    std::this_thread::sleep_for(2 * DELAY);
+    REQUIRE_EQ(calls, 0);
+}
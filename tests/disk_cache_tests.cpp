@@ -0,0 +1,169 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "disk_cache.hpp"
+#include "image.hpp"
+#include "render.hpp"
+
+namespace {
+// Every page of a cache in a fresh directory, removed afterwards
+class TempDir {
+public:
+    TempDir() : path_(std::filesystem::temp_directory_path() / ("yapdf-disk-cache-" + std::to_string(::getpid()))) {
+        std::filesystem::remove_all(path_);
+    }
+
+    ~TempDir() {
+        std::filesystem::remove_all(path_);
+    }
+
+    [[nodiscard]] std::string path() const {
+        return path_.string();
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+yapdf::Image page(std::uint32_t color) {
+    yapdf::Image img(8, 8);
+    for (int y = 0; y < img.height(); ++y) {
+        for (int x = 0; x < img.width(); ++x) {
+            img.row(y)[x] = color;
+        }
+    }
+    return img;
+}
+
+// Return the size of the file of a page, all pages of one color have the same
+std::uintmax_t pageBytes(const std::string& dir) {
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.path().extension() == ".page") {
+            return entry.file_size();
+        }
+    }
+    return 0;
+}
+} // namespace
+
+TEST_CASE("round trip") {
+    TempDir dir;
+    yapdf::DiskCache cache(dir.path(), 1 << 20);
+    const yapdf::Image img = page(0xff336699);
+    cache.store(1, {0, 1.0}, img);
+
+    const std::shared_ptr<yapdf::Image> loaded = cache.load(1, {0, 1.0});
+    REQUIRE(loaded);
+    REQUIRE_EQ(loaded->width(), img.width());
+    REQUIRE_EQ(loaded->height(), img.height());
+    REQUIRE_EQ(std::memcmp(loaded->data(), img.data(), img.size()), 0);
+
+    REQUIRE_FALSE(cache.load(2, {0, 1.0}));
+    REQUIRE_FALSE(cache.load(1, {1, 1.0}));
+    REQUIRE_FALSE(cache.load(1, {0, 2.0}));
+    REQUIRE_FALSE(cache.load(1, {0, 1.0, yapdf::ColorMode::Dark}));
+
+    // Another instance sees the same index
+    yapdf::DiskCache other(dir.path(), 1 << 20);
+    REQUIRE(other.load(1, {0, 1.0}));
+}
+
+TEST_CASE("eviction") {
+    TempDir dir;
+    const yapdf::Image img = page(0xffffffff);
+    std::uintmax_t bytes = 0;
+    {
+        yapdf::DiskCache probe(dir.path(), 1 << 20);
+        probe.store(0, {0, 1.0}, img);
+        bytes = pageBytes(dir.path());
+    }
+    REQUIRE_GT(bytes, 0);
+    std::filesystem::remove_all(dir.path());
+
+    // Thousands of erasures shift the probe sequences of clustered slots back, every page kept must still be found
+    constexpr int KEPT = 1000;
+    constexpr int STORED = 3000;
+    yapdf::DiskCache cache(dir.path(), KEPT * bytes);
+    for (int i = 0; i < STORED; ++i) {
+        cache.store(static_cast<std::uint64_t>(i) * 7919, {i % 97, 1.0 + i / 97}, img);
+        // Keep the first page recently used
+        if (i % 100 == 0) {
+            REQUIRE(cache.load(0, {0, 1.0}));
+        }
+    }
+
+    REQUIRE(cache.load(0, {0, 1.0}));
+    int found = 0;
+    for (int i = 1; i < STORED; ++i) {
+        const bool hit = cache.load(static_cast<std::uint64_t>(i) * 7919, {i % 97, 1.0 + i / 97}) != nullptr;
+        found += hit;
+        if (i >= STORED - KEPT + 1) {
+            REQUIRE(hit);
+        }
+    }
+    REQUIRE_EQ(found, KEPT - 1);
+}
+
+TEST_CASE("corrupted") {
+    TempDir dir;
+    const yapdf::Image img = page(0xff000000);
+
+    SUBCASE("truncated page") {
+        yapdf::DiskCache cache(dir.path(), 1 << 20);
+        cache.store(1, {0, 1.0}, img);
+        for (const auto& entry : std::filesystem::directory_iterator(dir.path())) {
+            if (entry.path().extension() == ".page") {
+                std::filesystem::resize_file(entry.path(), entry.file_size() - 1);
+            }
+        }
+
+        // A miss, and the entry is dropped so it can be stored again
+        REQUIRE_FALSE(cache.load(1, {0, 1.0}));
+        cache.store(1, {0, 1.0}, img);
+        REQUIRE(cache.load(1, {0, 1.0}));
+    }
+
+    SUBCASE("garbage page") {
+        yapdf::DiskCache cache(dir.path(), 1 << 20);
+        cache.store(1, {0, 1.0}, img);
+        for (const auto& entry : std::filesystem::directory_iterator(dir.path())) {
+            if (entry.path().extension() == ".page") {
+                std::ofstream(entry.path(), std::ios::binary | std::ios::trunc) << "not a page at all";
+            }
+        }
+        REQUIRE_FALSE(cache.load(1, {0, 1.0}));
+    }
+
+    SUBCASE("truncated index") {
+        {
+            yapdf::DiskCache cache(dir.path(), 1 << 20);
+            cache.store(1, {0, 1.0}, img);
+        }
+        std::filesystem::resize_file(dir.path() + "/index", 10);
+
+        // The index starts over
+        yapdf::DiskCache cache(dir.path(), 1 << 20);
+        REQUIRE_FALSE(cache.load(1, {0, 1.0}));
+        cache.store(1, {0, 1.0}, img);
+        REQUIRE(cache.load(1, {0, 1.0}));
+    }
+
+    SUBCASE("garbage index") {
+        std::filesystem::create_directories(dir.path());
+        std::ofstream(dir.path() + "/index", std::ios::binary) << std::string(4096, '\xff');
+
+        yapdf::DiskCache cache(dir.path(), 1 << 20);
+        REQUIRE_FALSE(cache.load(1, {0, 1.0}));
+        cache.store(1, {0, 1.0}, img);
+        REQUIRE(cache.load(1, {0, 1.0}));
+    }
+}
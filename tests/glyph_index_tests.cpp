@@ -0,0 +1,110 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glyph_index.hpp"
+
+namespace {
+// Lay out `lines` on a page, every byte is a glyph 1pt wide and 2pt high, and spaces separate words
+std::shared_ptr<const yapdf::PageText> layout(const std::vector<std::string>& lines) {
+    auto t = std::make_shared<yapdf::PageText>();
+    for (std::size_t y = 0; y < lines.size(); ++y) {
+        if (y > 0) {
+            t->text.push_back('\n');
+        }
+
+        for (std::size_t x = 0; x < lines[y].size(); ++x) {
+            if (lines[y][x] == ' ') {
+                t->text.push_back(' ');
+                continue;
+            }
+
+            t->offsets.push_back(static_cast<std::uint32_t>(t->text.size()));
+            t->x0.push_back(static_cast<float>(x));
+            t->y0.push_back(static_cast<float>(2 * y));
+            t->x1.push_back(static_cast<float>(x + 1));
+            t->y1.push_back(static_cast<float>(2 * y + 2));
+            t->text.push_back(lines[y][x]);
+        }
+    }
+    return t;
+}
+} // namespace
+
+TEST_CASE("at") {
+    // Glyphs: "foo" 0-2, "bar" 3-5, "baz" 6-8
+    const yapdf::GlyphIndex index(layout({"foo bar", "  baz"}));
+    REQUIRE_EQ(index.at(0.5f, 1), 0);
+    REQUIRE_EQ(index.at(6.5f, 1), 5);
+    REQUIRE_EQ(index.at(2.5f, 3), 6);
+    REQUIRE_EQ(index.at(3.5f, 1), -1);
+    REQUIRE_EQ(index.at(100, 100), -1);
+    REQUIRE_EQ(index.at(-1, 1), -1);
+}
+
+TEST_CASE("nearest") {
+    const yapdf::GlyphIndex index(layout({"foo bar", "  baz"}));
+    REQUIRE_EQ(index.nearest(1.5f, 1), 1);
+    REQUIRE_EQ(index.nearest(100, 1), 5);
+    REQUIRE_EQ(index.nearest(0, 100), 6);
+    REQUIRE_EQ(index.nearest(-5, -5), 0);
+
+    const yapdf::GlyphIndex empty(layout({}));
+    REQUIRE_EQ(empty.nearest(0, 0), -1);
+    REQUIRE_EQ(empty.at(0, 0), -1);
+    REQUIRE(empty.within({0, 0, 10, 10}).empty());
+}
+
+TEST_CASE("within") {
+    const yapdf::GlyphIndex index(layout({"foo bar", "  baz"}));
+    const std::vector<std::uint32_t> column = {2, 3, 6, 7, 8};
+    REQUIRE_EQ(index.within({2.5f, 0.5f, 4.5f, 3.5f}), column);
+    REQUIRE_EQ(index.within({4.5f, 3.5f, 2.5f, 0.5f}), column);
+    REQUIRE(index.within({20, 20, 30, 30}).empty());
+}
+
+TEST_CASE("word") {
+    const yapdf::GlyphIndex index(layout({"foo bar", "  baz"}));
+    REQUIRE_EQ(index.word(0), std::make_pair(0u, 3u));
+    REQUIRE_EQ(index.word(4), std::make_pair(3u, 6u));
+    REQUIRE_EQ(index.word(8), std::make_pair(6u, 9u));
+}
+
+TEST_CASE("dense page") {
+    // Every query agrees with a scan of all glyphs
+    std::vector<std::string> lines(200, std::string(120, 'x'));
+    for (std::size_t y = 0; y < lines.size(); ++y) {
+        lines[y][60] = ' ';
+        lines[y][(y * 7) % 60] = ' ';
+    }
+    const std::shared_ptr<const yapdf::PageText> t = layout(lines);
+    const yapdf::GlyphIndex index(t);
+
+    for (float y = -1.5f; y < 402; y += 3.7f) {
+        for (float x = -1.5f; x < 122; x += 1.3f) {
+            int hit = -1;
+            float best = 1e30f;
+            int near = -1;
+            for (std::size_t i = 0; i < t->glyphs(); ++i) {
+                const yapdf::Box b = t->box(i);
+                const float dx = std::max({b.x0 - x, 0.0f, x - b.x1});
+                const float dy = std::max({b.y0 - y, 0.0f, y - b.y1});
+                if (dx == 0 && dy == 0 && hit < 0) {
+                    hit = static_cast<int>(i);
+                }
+                if (dx * dx + dy * dy < best) {
+                    best = dx * dx + dy * dy;
+                    near = static_cast<int>(i);
+                }
+            }
+            REQUIRE_EQ(index.at(x, y), hit);
+            REQUIRE_EQ(index.nearest(x, y), near);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <utility>
+#include <vector>
+
+#include "layout.hpp"
+
+TEST_CASE("offsets") {
+    // A landscape page between portrait ones
+    const yapdf::Layout layout({{100, 200}, {200, 100}, {100, 200}});
+    REQUIRE_EQ(layout.pages(), 3);
+    REQUIRE_EQ(layout.offset(0, 2, 10), 0);
+    REQUIRE_EQ(layout.offset(1, 2, 10), 410);
+    REQUIRE_EQ(layout.offset(2, 2, 10), 620);
+    REQUIRE_EQ(layout.extent(2, 10), std::make_pair(400.0, 1020.0));
+    REQUIRE_EQ(layout.extent(1, 0), std::make_pair(200.0, 500.0));
+
+    REQUIRE_EQ(layout.pageAt(-50, 2, 10), 0);
+    REQUIRE_EQ(layout.pageAt(405, 2, 10), 0);
+    REQUIRE_EQ(layout.pageAt(410, 2, 10), 1);
+    REQUIRE_EQ(layout.pageAt(619, 2, 10), 1);
+    REQUIRE_EQ(layout.pageAt(5000, 2, 10), 2);
+}
+
+TEST_CASE("visible") {
+    const yapdf::Layout layout({{100, 200}, {200, 100}, {100, 200}});
+    REQUIRE_EQ(layout.visible(0, 100, 2, 10), std::make_pair(0, 1));
+    REQUIRE_EQ(layout.visible(0, 411, 2, 10), std::make_pair(0, 2));
+    // Only gaps around
+    REQUIRE_EQ(layout.visible(400, 10, 2, 10), std::make_pair(1, 1));
+    REQUIRE_EQ(layout.visible(405, 300, 2, 10), std::make_pair(1, 3));
+    REQUIRE_EQ(layout.visible(0, 0, 2, 10), std::make_pair(0, 0));
+    REQUIRE_EQ(layout.visible(2000, 100, 2, 10), std::make_pair(3, 3));
+
+    const yapdf::Layout empty({});
+    REQUIRE_EQ(empty.pageAt(0, 1, 0), -1);
+    REQUIRE_EQ(empty.visible(0, 100, 1, 0), std::make_pair(0, 0));
+    REQUIRE_EQ(empty.extent(1, 10), std::make_pair(0.0, 0.0));
+}
+
+TEST_CASE("update") {
+    yapdf::Layout layout(std::vector<yapdf::PageSize>(10000, {100, 100}));
+    REQUIRE_EQ(layout.offset(9999, 1, 0), 999900);
+    REQUIRE_EQ(layout.pageAt(500050, 1, 0), 5000);
+
+    layout.update(1, {{300, 50}, {100, 150}});
+    REQUIRE_EQ(layout.offset(2, 1, 0), 150);
+    REQUIRE_EQ(layout.offset(3, 1, 0), 300);
+    REQUIRE_EQ(layout.offset(9999, 1, 0), 999900);
+    REQUIRE_EQ(layout.extent(1, 0).first, 300);
+    REQUIRE_EQ(layout.size(2).height, 150);
+
+    // Sizes past the last page are ignored
+    layout.update(9999, {{100, 200}, {100, 200}});
+    REQUIRE_EQ(layout.extent(1, 0).second, 1000100);
+}
@@ -0,0 +1,56 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "links.hpp"
+
+namespace {
+// Every byte but separators is a glyph
+yapdf::PageText layout(const std::string& text) {
+    yapdf::PageText t;
+    t.text = text;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != ' ' && text[i] != '\n') {
+            t.offsets.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    return t;
+}
+
+std::vector<std::string> uris(const yapdf::LinkMap& links) {
+    std::vector<std::string> out;
+    for (const yapdf::Link& l : links.links()) {
+        out.push_back(l.uri);
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("extract") {
+    const yapdf::PageText t = layout("See https://example.com/a_(b), or www.gnu.org.\n"
+                                     "Mail <mailto:me@example.com>; xhttp://no [http://x.org/y] file://");
+    const std::vector<std::string> expected = {"https://example.com/a_(b)", "http://www.gnu.org",
+                                               "mailto:me@example.com", "http://x.org/y"};
+    REQUIRE_EQ(uris(yapdf::LinkMap::extract(t)), expected);
+
+    const yapdf::LinkMap links = yapdf::LinkMap::extract(t);
+    REQUIRE_EQ(links.links()[0].first, 3);
+    REQUIRE_EQ(links.links()[0].last, 28);
+    REQUIRE(yapdf::LinkMap::extract(layout("no links here: http:// www.")).links().empty());
+}
+
+TEST_CASE("at") {
+    const yapdf::LinkMap links({{10, 20, "https://c"}, {0, 5, "https://a"}, {25, 26, "https://b"}});
+    REQUIRE_EQ(links.at(0)->uri, "https://a");
+    REQUIRE_EQ(links.at(4)->uri, "https://a");
+    REQUIRE_EQ(links.at(5), nullptr);
+    REQUIRE_EQ(links.at(10)->uri, "https://c");
+    REQUIRE_EQ(links.at(19)->uri, "https://c");
+    REQUIRE_EQ(links.at(20), nullptr);
+    REQUIRE_EQ(links.at(25)->uri, "https://b");
+    REQUIRE_EQ(links.at(1000), nullptr);
+    REQUIRE_EQ(yapdf::LinkMap({}).at(0), nullptr);
+}
@@ -0,0 +1,84 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "mipmap.hpp"
+
+namespace {
+std::shared_ptr<const yapdf::Image> filled(int width, int height, std::uint32_t px) {
+    auto img = std::make_shared<yapdf::Image>(width, height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            img->row(y)[x] = px;
+        }
+    }
+    return img;
+}
+} // namespace
+
+TEST_CASE("mipmapBase") {
+    REQUIRE_EQ(yapdf::mipmapBase(1.0), 1.0);
+    REQUIRE_EQ(yapdf::mipmapBase(1.3), 2.0);
+    REQUIRE_EQ(yapdf::mipmapBase(0.3), 0.5);
+    REQUIRE_EQ(yapdf::mipmapBase(3.9), 4.0);
+}
+
+TEST_CASE("levels") {
+    const yapdf::Mipmap mipmap({0, 2.0}, filled(600, 800, 0xff204060));
+    // 600x800, 300x400, 150x200, 75x100
+    REQUIRE_EQ(mipmap.levels(), 4);
+    REQUIRE_EQ(mipmap.level(3).width(), 75);
+    REQUIRE_EQ(mipmap.level(3).height(), 100);
+    REQUIRE_EQ(mipmap.level(3).row(50)[30], 0xff204060);
+
+    // The smallest level at or above a scale stands in for it
+    REQUIRE_EQ(mipmap.nearest(2.0).first, 2.0);
+    REQUIRE_EQ(mipmap.nearest(1.9).first, 2.0);
+    REQUIRE_EQ(mipmap.nearest(0.5).first, 0.5);
+    REQUIRE_EQ(mipmap.nearest(0.4).first, 0.5);
+    REQUIRE_EQ(mipmap.nearest(0.1).first, 0.25);
+    REQUIRE_EQ(mipmap.nearest(0.1).second->width(), 75);
+
+    // Any scale up to the base keeps the aspect ratio and the colors, also below the smallest level
+    for (double scale : {2.0, 1.5, 1.0, 0.7, 0.25, 0.1, 0.02}) {
+        const std::unique_ptr<yapdf::Image> img = mipmap.draw(scale);
+        REQUIRE_EQ(img->width(), static_cast<int>(std::lround(300 * scale)));
+        REQUIRE_EQ(img->height(), static_cast<int>(std::lround(400 * scale)));
+        REQUIRE_EQ(img->row(img->height() / 2)[img->width() / 2], 0xff204060);
+    }
+}
+
+TEST_CASE("cache") {
+    // Pyramids of 64x64 pages are a single level
+    constexpr std::size_t BYTES = 64 * 64 * 4;
+    yapdf::MipmapCache cache(2 * BYTES);
+    cache.insert(std::make_shared<const yapdf::Mipmap>(yapdf::RenderKey{0, 2.0}, filled(64, 64, 0)));
+    cache.insert(std::make_shared<const yapdf::Mipmap>(yapdf::RenderKey{1, 1.0}, filled(64, 64, 0)));
+
+    REQUIRE(cache.find({0, 1.5}));
+    REQUIRE_FALSE(cache.find({0, 2.5}));
+    REQUIRE_FALSE(cache.find({2, 1.0}));
+
+    // A larger base replaces the pyramid of the page
+    cache.insert(std::make_shared<const yapdf::Mipmap>(yapdf::RenderKey{0, 4.0}, filled(64, 64, 0)));
+    REQUIRE_EQ(cache.find({0, 2.5})->key().scale, 4.0);
+    REQUIRE(cache.find({1, 1.0}));
+
+    // Page 0 is the least recently used
+    cache.insert(std::make_shared<const yapdf::Mipmap>(yapdf::RenderKey{2, 1.0}, filled(64, 64, 0)));
+    REQUIRE_FALSE(cache.find({0, 1.0}));
+    REQUIRE(cache.find({1, 1.0}));
+    REQUIRE(cache.find({2, 1.0}));
+
+    // A pyramid over budget is kept alone
+    const auto big = std::make_shared<const yapdf::Mipmap>(yapdf::RenderKey{3, 1.0}, filled(128, 128, 0));
+    REQUIRE_EQ(big->bytes(), 5 * BYTES);
+    cache.insert(big);
+    REQUIRE(cache.find({3, 1.0}));
+    REQUIRE_FALSE(cache.find({1, 1.0}));
+    REQUIRE_FALSE(cache.find({2, 1.0}));
+}
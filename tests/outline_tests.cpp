@@ -0,0 +1,40 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "outline.hpp"
+
+TEST_CASE("subtree") {
+    // 0
+    //   1
+    //     2
+    //   3
+    // 4
+    //   5
+    const yapdf::Outline outline({{"Chapter 1", 0, true, 4},
+                                  {"Section 1.1", 1, false, 3},
+                                  {"Section 1.1.1", 2, false, 3},
+                                  {"Section 1.2", 1, false, 4},
+                                  {"Chapter 2", 0, false, 6},
+                                  {"Section 2.1", 1, false, 6}});
+
+    const std::vector<std::uint32_t> top = {0, 4};
+    REQUIRE_EQ(outline.subtree(-1, 1), top);
+    const std::vector<std::uint32_t> two = {0, 1, 3, 4, 5};
+    REQUIRE_EQ(outline.subtree(-1, 2), two);
+    const std::vector<std::uint32_t> all = {0, 1, 2, 3, 4, 5};
+    REQUIRE_EQ(outline.subtree(-1, 100), all);
+
+    const std::vector<std::uint32_t> children = {1, 3};
+    REQUIRE_EQ(outline.subtree(0, 1), children);
+    const std::vector<std::uint32_t> deep = {2};
+    REQUIRE_EQ(outline.subtree(1, 1), deep);
+    REQUIRE(outline.subtree(2, 1).empty());
+    REQUIRE(outline.subtree(-1, 0).empty());
+
+    REQUIRE_THROWS_AS(outline.subtree(6, 1), std::out_of_range);
+    REQUIRE_THROWS_AS(outline.subtree(-2, 1), std::out_of_range);
+}
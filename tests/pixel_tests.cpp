@@ -0,0 +1,304 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "pixel.hpp"
+
+namespace {
+std::vector<std::uint32_t> noise(std::size_t n, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::uint32_t> px(n);
+    for (auto& p : px) {
+        p = rng();
+    }
+    return px;
+}
+
+std::uint8_t channel(std::uint32_t px, int i) {
+    return static_cast<std::uint8_t>(px >> (8 * i));
+}
+
+// Random premultiplied pixels, with a few fully opaque and transparent ones
+std::vector<std::uint32_t> premultiplied(std::size_t n, std::uint32_t seed) {
+    std::vector<std::uint32_t> px = noise(n, seed);
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::uint32_t a = i % 3 == 0 ? 0xff : i % 7 == 0 ? 0 : px[i] >> 24;
+        std::uint32_t p = a << 24;
+        for (int c = 0; c < 3; ++c) {
+            p |= channel(px[i], c) * a / 255 << (8 * c);
+        }
+        px[i] = p;
+    }
+    return px;
+}
+} // namespace
+
+TEST_CASE("boxHalve") {
+    // odd width to exercise the scalar tail
+    for (int n : {1, 2, 7, 64, 101}) {
+        const std::vector<std::uint32_t> row0 = noise(2 * n, 1);
+        const std::vector<std::uint32_t> row1 = noise(2 * n, 2);
+        std::vector<std::uint32_t> out(n);
+        yapdf::boxHalve(row0.data(), row1.data(), out.data(), n);
+
+        for (int x = 0; x < n; ++x) {
+            for (int c = 0; c < 4; ++c) {
+                const int sum = channel(row0[2 * x], c) + channel(row0[2 * x + 1], c) + channel(row1[2 * x], c) +
+                                channel(row1[2 * x + 1], c);
+                REQUIRE_EQ(channel(out[x], c), (sum + 2) / 4);
+            }
+        }
+    }
+
+    SUBCASE("uniform") {
+        const std::vector<std::uint32_t> row(32, 0xff336699);
+        std::vector<std::uint32_t> out(16);
+        yapdf::boxHalve(row.data(), row.data(), out.data(), 16);
+        for (std::uint32_t px : out) {
+            REQUIRE_EQ(px, 0xff336699);
+        }
+    }
+}
+
+TEST_CASE("resizeBilinear") {
+    SUBCASE("identity") {
+        const std::vector<std::uint32_t> src = noise(7 * 5, 3);
+        std::vector<std::uint32_t> dst(7 * 5);
+        yapdf::resizeBilinear(src.data(), 7, 5, 7, dst.data(), 7, 5, 7);
+        REQUIRE_EQ(dst, src);
+    }
+
+    SUBCASE("uniform") {
+        const std::vector<std::uint32_t> src(10 * 10, 0xff336699);
+        for (int size : {1, 3, 17, 40}) {
+            std::vector<std::uint32_t> dst(static_cast<std::size_t>(size) * size);
+            yapdf::resizeBilinear(src.data(), 10, 10, 10, dst.data(), size, size, size);
+            for (std::uint32_t px : dst) {
+                REQUIRE_EQ(px, 0xff336699);
+            }
+        }
+    }
+
+    SUBCASE("gradient") {
+        // Doubling a black and white pair interpolates between them
+        const std::vector<std::uint32_t> src = {0xff000000, 0xffffffff};
+        std::vector<std::uint32_t> dst(4);
+        yapdf::resizeBilinear(src.data(), 2, 1, 2, dst.data(), 4, 1, 4);
+        REQUIRE_EQ(dst[0], 0xff000000);
+        REQUIRE_EQ(channel(dst[1], 0), 0x40);
+        REQUIRE_EQ(channel(dst[2], 0), 0xbf);
+        REQUIRE_EQ(dst[3], 0xffffffff);
+    }
+
+    SUBCASE("stride") {
+        // Padding pixels are never read or written
+        const std::vector<std::uint32_t> src = {0xff102030, 0xdeadbeef, 0xff102030, 0xdeadbeef};
+        std::vector<std::uint32_t> dst(3 * 3, 0);
+        yapdf::resizeBilinear(src.data(), 1, 2, 2, dst.data(), 2, 3, 3);
+        for (int y = 0; y < 3; ++y) {
+            REQUIRE_EQ(dst[3 * y], 0xff102030);
+            REQUIRE_EQ(dst[3 * y + 1], 0xff102030);
+            REQUIRE_EQ(dst[3 * y + 2], 0);
+        }
+    }
+}
+
+TEST_CASE("invertLightness") {
+    for (int n : {1, 3, 4, 64, 101}) {
+        const std::vector<std::uint32_t> src = premultiplied(n, 4);
+        std::vector<std::uint32_t> px = src;
+        yapdf::invertLightness(px.data(), n);
+
+        for (int x = 0; x < n; ++x) {
+            const int a = channel(src[x], 3);
+            const int r = channel(src[x], 2);
+            const int g = channel(src[x], 1);
+            const int b = channel(src[x], 0);
+            const int d = a - std::max({r, g, b}) - std::min({r, g, b});
+            REQUIRE_EQ(channel(px[x], 3), a);
+            for (int c = 0; c < 3; ++c) {
+                REQUIRE_EQ(channel(px[x], c), channel(src[x], c) + d);
+            }
+        }
+    }
+
+    SUBCASE("colors") {
+        // White and black swap, grays mirror, saturated hues stay
+        std::vector<std::uint32_t> px = {0xffffffff, 0xff000000, 0xff404040, 0xffff0000, 0xff3366cc, 0x00000000};
+        yapdf::invertLightness(px.data(), static_cast<int>(px.size()));
+        REQUIRE_EQ(px[0], 0xff000000);
+        REQUIRE_EQ(px[1], 0xffffffff);
+        REQUIRE_EQ(px[2], 0xffbfbfbf);
+        REQUIRE_EQ(px[3], 0xffff0000);
+        REQUIRE_EQ(px[4], 0xff3366cc);
+        REQUIRE_EQ(px[5], 0x00000000);
+    }
+}
+
+TEST_CASE("remapLuminance") {
+    constexpr std::uint32_t dark = 0x5b4636;
+    constexpr std::uint32_t light = 0xf4ecd8;
+
+    for (int n : {1, 3, 4, 64, 101}) {
+        const std::vector<std::uint32_t> src = premultiplied(n, 5);
+        std::vector<std::uint32_t> px = src;
+        yapdf::remapLuminance(px.data(), n, dark, light);
+
+        for (int x = 0; x < n; ++x) {
+            const std::uint32_t a = channel(src[x], 3);
+            const std::uint32_t y = std::min<std::uint32_t>(
+                a, (54 * channel(src[x], 2) + 183 * channel(src[x], 1) + 19 * channel(src[x], 0) + 128) >> 8);
+            REQUIRE_EQ(channel(px[x], 3), a);
+            for (int c = 0; c < 3; ++c) {
+                const std::uint32_t t = channel(dark, c) * (a - y) + channel(light, c) * y;
+                REQUIRE_EQ(channel(px[x], c), (t + 127) / 255);
+            }
+        }
+    }
+
+    SUBCASE("colors") {
+        std::vector<std::uint32_t> px = {0xff000000, 0xffffffff, 0x00000000, 0x80808080};
+        yapdf::remapLuminance(px.data(), static_cast<int>(px.size()), dark, light);
+        REQUIRE_EQ(px[0], 0xff000000 | dark);
+        REQUIRE_EQ(px[1], 0xff000000 | light);
+        REQUIRE_EQ(px[2], 0x00000000);
+        // Half transparent white is half of `light`
+        REQUIRE_EQ(px[3], 0x80000000 | 0x7a766c);
+    }
+}
+
+TEST_CASE("premultiply") {
+    for (yapdf::Simd level : {yapdf::Simd::Scalar, yapdf::Simd::Sse2, yapdf::Simd::Avx2}) {
+        CAPTURE(yapdf::useSimd(level));
+        for (int n : {1, 7, 8, 64, 101}) {
+            const std::vector<std::uint32_t> src = noise(n, 6);
+            std::vector<std::uint32_t> px = src;
+            yapdf::premultiply(px.data(), n);
+
+            for (int x = 0; x < n; ++x) {
+                const int a = channel(src[x], 3);
+                REQUIRE_EQ(channel(px[x], 3), a);
+                for (int c = 0; c < 3; ++c) {
+                    REQUIRE_EQ(channel(px[x], c), (channel(src[x], c) * a + 127) / 255);
+                }
+            }
+        }
+    }
+    yapdf::useSimd(yapdf::detectSimd());
+}
+
+TEST_CASE("unpremultiply") {
+    for (yapdf::Simd level : {yapdf::Simd::Scalar, yapdf::Simd::Sse2, yapdf::Simd::Avx2}) {
+        CAPTURE(yapdf::useSimd(level));
+        for (int n : {1, 7, 8, 64, 101}) {
+            // Not all premultiplied, to check colors above alpha saturate
+            std::vector<std::uint32_t> src = premultiplied(n, 7);
+            src[0] = 0x40ff8000;
+            std::vector<std::uint32_t> px = src;
+            yapdf::unpremultiply(px.data(), n);
+
+            for (int x = 0; x < n; ++x) {
+                const int a = channel(src[x], 3);
+                REQUIRE_EQ(channel(px[x], 3), a);
+                for (int c = 0; c < 3; ++c) {
+                    const int expected = a == 0 ? 0 : std::min(255, (510 * channel(src[x], c) + a) / (2 * a));
+                    REQUIRE_EQ(channel(px[x], c), expected);
+                }
+            }
+        }
+
+        SUBCASE("round trip") {
+            // Opaque pixels survive, and premultiplying again gives back the premultiplied pixels
+            std::vector<std::uint32_t> px = premultiplied(256, 8);
+            const std::vector<std::uint32_t> src = px;
+            yapdf::unpremultiply(px.data(), static_cast<int>(px.size()));
+            yapdf::premultiply(px.data(), static_cast<int>(px.size()));
+            REQUIRE_EQ(px, src);
+        }
+    }
+    yapdf::useSimd(yapdf::detectSimd());
+}
+
+TEST_CASE("toArgb32") {
+    for (yapdf::Simd level : {yapdf::Simd::Scalar, yapdf::Simd::Sse2, yapdf::Simd::Avx2}) {
+        CAPTURE(yapdf::useSimd(level));
+        for (int n : {1, 9, 10, 16, 17, 101}) {
+            const std::vector<std::uint32_t> words = noise(n, 9);
+            const auto* bytes = reinterpret_cast<const std::uint8_t*>(words.data());
+            std::vector<std::uint32_t> out(n);
+
+            yapdf::toArgb32(yapdf::PixelFormat::Gray8, bytes, out.data(), n);
+            for (int x = 0; x < n; ++x) {
+                REQUIRE_EQ(out[x], 0xff000000 | 0x010101 * std::uint32_t(bytes[x]));
+            }
+
+            // Only the first 3 * n bytes are read
+            for (auto format : {yapdf::PixelFormat::Rgb24, yapdf::PixelFormat::Bgr24}) {
+                const std::vector<std::uint8_t> rgb(bytes, bytes + 3 * n);
+                yapdf::toArgb32(format, rgb.data(), out.data(), n);
+                const int r = format == yapdf::PixelFormat::Rgb24 ? 0 : 2;
+                for (int x = 0; x < n; ++x) {
+                    REQUIRE_EQ(channel(out[x], 3), 0xff);
+                    REQUIRE_EQ(channel(out[x], 2), rgb[3 * x + r]);
+                    REQUIRE_EQ(channel(out[x], 1), rgb[3 * x + 1]);
+                    REQUIRE_EQ(channel(out[x], 0), rgb[3 * x + 2 - r]);
+                }
+            }
+
+            yapdf::toArgb32(yapdf::PixelFormat::Argb32, bytes, out.data(), n);
+            REQUIRE_EQ(out, words);
+
+            std::vector<std::uint32_t> expected = words;
+            yapdf::premultiply(expected.data(), n);
+            yapdf::toArgb32(yapdf::PixelFormat::StraightArgb32, bytes, out.data(), n);
+            REQUIRE_EQ(out, expected);
+        }
+    }
+    yapdf::useSimd(yapdf::detectSimd());
+}
+
+TEST_CASE("toRgb24") {
+    for (yapdf::Simd level : {yapdf::Simd::Scalar, yapdf::Simd::Sse2, yapdf::Simd::Avx2}) {
+        CAPTURE(yapdf::useSimd(level));
+        for (int n : {1, 9, 10, 17, 101}) {
+            const std::vector<std::uint32_t> src = noise(n, 10);
+            std::vector<std::uint8_t> out(3 * n);
+            yapdf::toRgb24(src.data(), out.data(), n);
+            for (int x = 0; x < n; ++x) {
+                REQUIRE_EQ(out[3 * x], channel(src[x], 2));
+                REQUIRE_EQ(out[3 * x + 1], channel(src[x], 1));
+                REQUIRE_EQ(out[3 * x + 2], channel(src[x], 0));
+            }
+        }
+    }
+    yapdf::useSimd(yapdf::detectSimd());
+}
+
+TEST_CASE("foregroundSpan") {
+    constexpr std::uint32_t paper = 0xffffffff;
+    for (int n : {1, 3, 4, 9, 64, 101}) {
+        std::vector<std::uint32_t> row(n, paper);
+        REQUIRE_EQ(yapdf::foregroundSpan(row.data(), n, paper, 24), std::make_pair(0, 0));
+
+        // Every span, including ones within a vector of 4 and across the scalar tail
+        for (int first = 0; first < n; ++first) {
+            for (int last = first + 1; last <= n; ++last) {
+                std::fill(row.begin(), row.end(), paper);
+                row[first] = 0xff000000;
+                row[last - 1] = 0xff000000;
+                REQUIRE_EQ(yapdf::foregroundSpan(row.data(), n, paper, 24), std::make_pair(first, last));
+            }
+        }
+    }
+
+    SUBCASE("tolerance") {
+        const std::vector<std::uint32_t> row = {0xffe8e8e8, 0xffffffe6, 0xfff0f0f0, 0xffffffff, 0xfff0f0f0};
+        REQUIRE_EQ(yapdf::foregroundSpan(row.data(), 5, 0xffffffff, 24), std::make_pair(1, 2));
+        REQUIRE_EQ(yapdf::foregroundSpan(row.data(), 5, 0xffffffff, 10), std::make_pair(0, 5));
+        REQUIRE_EQ(yapdf::foregroundSpan(row.data(), 5, 0xffffffff, 255), std::make_pair(0, 0));
+    }
+}
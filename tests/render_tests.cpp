@@ -0,0 +1,97 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include "image.hpp"
+#include "render.hpp"
+
+namespace {
+constexpr int SIZE = 100;
+constexpr std::size_t BYTES = SIZE * SIZE * 4;
+
+// Return a page whose rows start with `noisy` random pixels, then run white. It compresses to about `noisy` percent.
+std::shared_ptr<const yapdf::Image> page(int noisy, unsigned seed) {
+    std::mt19937 rng(seed);
+    auto img = std::make_shared<yapdf::Image>(SIZE, SIZE);
+    for (int y = 0; y < SIZE; ++y) {
+        for (int x = 0; x < SIZE; ++x) {
+            img->row(y)[x] = x < noisy ? rng() | 0xff000000 : 0xffffffff;
+        }
+    }
+    return img;
+}
+
+bool same(const yapdf::Image& a, const yapdf::Image& b) {
+    return a.width() == b.width() && a.height() == b.height() && std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+} // namespace
+
+TEST_CASE("cold tier") {
+    // The hot tier holds 3 pages, the cold tier what's left of the budget
+    const auto renderer = std::make_shared<yapdf::Renderer>(nullptr, 4 * BYTES);
+    REQUIRE_EQ(yapdf::RENDER_COLD_SHARE, 4);
+
+    SUBCASE("round trip") {
+        const std::shared_ptr<const yapdf::Image> first = page(10, 0);
+        renderer->insert({0, 1.0}, first);
+        for (int i = 1; i < 4; ++i) {
+            renderer->insert({i, 1.0}, page(10, i));
+        }
+
+        const auto [hot, cold] = renderer->usage();
+        REQUIRE_EQ(hot, 3 * BYTES);
+        REQUIRE_GT(cold, 0);
+        REQUIRE_LE(cold, BYTES / 2);
+
+        // Only `thaw` looks into the cold tier, and the page stays there
+        REQUIRE_FALSE(renderer->cached({0, 1.0}));
+        const std::shared_ptr<const yapdf::Image> thawed = renderer->thaw({0, 1.0});
+        REQUIRE(thawed);
+        REQUIRE(same(*thawed, *first));
+        REQUIRE_EQ(renderer->usage().second, cold);
+        REQUIRE_FALSE(renderer->thaw({1, 1.0}));
+    }
+
+    SUBCASE("nearest") {
+        for (int i = 0; i < 4; ++i) {
+            renderer->insert({i, 1.0}, page(10, i));
+        }
+
+        // Stand-ins come from the hot tier only, they're drawn on the main thread
+        REQUIRE_FALSE(renderer->nearest({0, 1.5}).second);
+        const auto [key, img] = renderer->nearest({1, 1.5});
+        REQUIRE_EQ(key.scale, 1.0);
+        REQUIRE(img);
+        REQUIRE_FALSE(renderer->nearest({1, 1.5, yapdf::ColorMode::Dark}).second);
+    }
+
+    SUBCASE("incompressible") {
+        // Pages that don't shrink by half are dropped
+        for (int i = 0; i < 4; ++i) {
+            renderer->insert({i, 1.0}, page(SIZE, i));
+        }
+        REQUIRE_EQ(renderer->usage().second, 0);
+        REQUIRE_FALSE(renderer->thaw({0, 1.0}));
+    }
+
+    SUBCASE("budget") {
+        // Frozen pages take about 40% of a page, and the cold tier has room for one page
+        for (int i = 0; i < 6; ++i) {
+            renderer->insert({i, 1.0}, page(40, i));
+        }
+
+        const auto [hot, cold] = renderer->usage();
+        REQUIRE_EQ(hot, 3 * BYTES);
+        REQUIRE_LE(hot + cold, 4 * BYTES);
+        REQUIRE_GT(cold, BYTES / 2);
+
+        // The oldest frozen page was evicted
+        REQUIRE_FALSE(renderer->thaw({0, 1.0}));
+        REQUIRE(renderer->thaw({1, 1.0}));
+        REQUIRE(renderer->thaw({2, 1.0}));
+    }
+}
@@ -0,0 +1,251 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "search.hpp"
+#include "substring.hpp"
+#include "text.hpp"
+
+namespace {
+// Lay out ASCII `lines` on a grid, one point per glyph. Spaces and newlines are separators as poppler reports them.
+yapdf::PageText layout(const std::vector<std::string>& lines) {
+    yapdf::PageText t;
+    for (std::size_t y = 0; y < lines.size(); ++y) {
+        if (y > 0) {
+            t.text.push_back('\n');
+        }
+
+        for (std::size_t x = 0; x < lines[y].size(); ++x) {
+            if (lines[y][x] != ' ') {
+                t.offsets.push_back(static_cast<std::uint32_t>(t.text.size()));
+                t.x0.push_back(static_cast<float>(x));
+                t.y0.push_back(static_cast<float>(y));
+                t.x1.push_back(static_cast<float>(x + 1));
+                t.y1.push_back(static_cast<float>(y + 1));
+            }
+            t.text.push_back(lines[y][x]);
+        }
+    }
+    return t;
+}
+} // namespace
+
+TEST_CASE("findAll") {
+    const yapdf::PageText t = layout({"Foo bar foo", "foofoo"});
+
+    SUBCASE("case sensitive") {
+        const std::vector<yapdf::Match> expected = {{6, 9}, {9, 12}, {12, 15}};
+        REQUIRE_EQ(yapdf::findAll(t, "foo", yapdf::Folding::None), expected);
+    }
+
+    SUBCASE("fold case") {
+        const std::vector<yapdf::Match> expected = {{0, 3}, {6, 9}, {9, 12}, {12, 15}};
+        REQUIRE_EQ(yapdf::findAll(t, "FOO", yapdf::Folding::Case), expected);
+    }
+
+    SUBCASE("across separators") {
+        const std::vector<yapdf::Match> expected = {{3, 9}};
+        REQUIRE_EQ(yapdf::findAll(t, "bar foo", yapdf::Folding::None), expected);
+    }
+
+    SUBCASE("non-overlapping") {
+        const yapdf::PageText aaa = layout({"aaaa"});
+        const std::vector<yapdf::Match> expected = {{0, 2}, {2, 4}};
+        REQUIRE_EQ(yapdf::findAll(aaa, "aa", yapdf::Folding::None), expected);
+    }
+
+    SUBCASE("nothing") {
+        REQUIRE(yapdf::findAll(t, "", yapdf::Folding::None).empty());
+        REQUIRE(yapdf::findAll(t, " ", yapdf::Folding::None).empty());
+        REQUIRE(yapdf::findAll(t, "baz", yapdf::Folding::Case).empty());
+    }
+}
+
+TEST_CASE("boxesOf") {
+    const yapdf::PageText t = layout({"Foo bar foo", "foofoo"});
+
+    // "foo\nfoo" spans two lines
+    const std::vector<yapdf::Match> found = yapdf::findAll(t, "foo\nfoo", yapdf::Folding::None);
+    REQUIRE_EQ(found.size(), 1);
+
+    const std::vector<yapdf::Box> boxes = yapdf::boxesOf(t, found[0]);
+    REQUIRE_EQ(boxes.size(), 2);
+    REQUIRE_EQ(boxes[0].x0, 8);
+    REQUIRE_EQ(boxes[0].x1, 11);
+    REQUIRE_EQ(boxes[0].y0, 0);
+    REQUIRE_EQ(boxes[1].x0, 0);
+    REQUIRE_EQ(boxes[1].x1, 3);
+    REQUIRE_EQ(boxes[1].y0, 1);
+}
+
+TEST_CASE("refine") {
+    const yapdf::PageText t = layout({"baaab Baab"});
+
+    // Overlapping occurrences are kept, so a longer query misses nothing
+    const std::vector<std::uint32_t> aa = yapdf::occurrences(t.text, "aa", false);
+    const std::vector<std::uint32_t> expectedAa = {1, 2, 7};
+    REQUIRE_EQ(aa, expectedAa);
+
+    const std::vector<std::uint32_t> aab = yapdf::refine(t.text, aa, "aab", false);
+    const std::vector<std::uint32_t> expectedAab = {2, 7};
+    REQUIRE_EQ(aab, expectedAab);
+    REQUIRE_EQ(aab, yapdf::occurrences(t.text, "aab", false));
+
+    SUBCASE("fold case") {
+        const std::vector<std::uint32_t> b = yapdf::occurrences(t.text, "b", true);
+        const std::vector<std::uint32_t> expectedB = {0, 4, 6, 9};
+        REQUIRE_EQ(b, expectedB);
+
+        const std::vector<std::uint32_t> ba = yapdf::refine(t.text, b, "BA", true);
+        const std::vector<std::uint32_t> expectedBa = {0, 6};
+        REQUIRE_EQ(ba, expectedBa);
+    }
+
+    SUBCASE("past the end") {
+        REQUIRE(yapdf::refine(t.text, {9}, "bx", false).empty());
+    }
+}
+
+TEST_CASE("findSubstring") {
+    // Long enough to go through the vectorized loop and the scalar tail
+    std::mt19937 rng(42);
+    std::string hay(1000, ' ');
+    for (char& c : hay) {
+        c = "abAB"[rng() % 4];
+    }
+
+    for (const std::string needle : {"a", "ab", "abba", "bAbA", "aaaaaaaaaaaaaaaaaaaa", "x"}) {
+        for (std::size_t from : {0, 1, 15, 16, 17, 500, 999, 1000}) {
+            REQUIRE_EQ(yapdf::findSubstring(hay, needle, false, from), hay.find(needle, from));
+        }
+    }
+
+    SUBCASE("fold case") {
+        const std::string text = "The quick brown fox jumps over the lazy dog, THE END.";
+        REQUIRE_EQ(yapdf::findSubstring(text, "the", true), 0);
+        REQUIRE_EQ(yapdf::findSubstring(text, "the", true, 1), 31);
+        REQUIRE_EQ(yapdf::findSubstring(text, "the end", true), 45);
+        REQUIRE_EQ(yapdf::findSubstring(text, "dog,", true), 40);
+        // Only letters are folded
+        REQUIRE_EQ(yapdf::findSubstring(text, "dog\x0c", true), std::string::npos);
+    }
+
+    SUBCASE("edges") {
+        REQUIRE_EQ(yapdf::findSubstring("", "", false), 0);
+        REQUIRE_EQ(yapdf::findSubstring("abc", "", false, 3), 3);
+        REQUIRE_EQ(yapdf::findSubstring("abc", "abcd", false), std::string::npos);
+        REQUIRE_EQ(yapdf::findSubstring("abc", "c", false, 4), std::string::npos);
+    }
+}
+
+TEST_CASE("requiredLiteral") {
+    REQUIRE_EQ(yapdf::requiredLiteral("hello"), "hello");
+    REQUIRE_EQ(yapdf::requiredLiteral("foo\\d+barbaz"), "barbaz");
+    REQUIRE_EQ(yapdf::requiredLiteral("colou?r"), "colo");
+    REQUIRE_EQ(yapdf::requiredLiteral("ab*cd"), "cd");
+    REQUIRE_EQ(yapdf::requiredLiteral("x{0,3}yz"), "yz");
+    REQUIRE_EQ(yapdf::requiredLiteral("x{2}y"), "x");
+    REQUIRE_EQ(yapdf::requiredLiteral("a\\.b"), "a.b");
+    REQUIRE_EQ(yapdf::requiredLiteral("[a)|]+long(er|est)"), "long");
+    REQUIRE_EQ(yapdf::requiredLiteral("cat|dog"), "");
+    REQUIRE_EQ(yapdf::requiredLiteral("^.*$"), "");
+
+    SUBCASE("escapes") {
+        // The code, name or number of an escape isn't a literal
+        REQUIRE_EQ(yapdf::requiredLiteral("\\x41BC"), "BC");
+        REQUIRE_EQ(yapdf::requiredLiteral("\\u00e9tude"), "tude");
+        REQUIRE_EQ(yapdf::requiredLiteral("\\cJab"), "ab");
+        REQUIRE_EQ(yapdf::requiredLiteral("(?<w>a)\\k<word>xy"), "xy");
+        REQUIRE_EQ(yapdf::requiredLiteral("(a)\\12xyz"), "xyz");
+        REQUIRE_EQ(yapdf::requiredLiteral("ab\\x4"), "ab");
+    }
+}
+
+TEST_CASE("regexMatches") {
+    const yapdf::PageText t = layout({"Figure 12 and figure 3", "Table 7"});
+    const std::regex re("figure \\d+", std::regex::ECMAScript | std::regex::icase);
+
+    const std::vector<yapdf::Match> expected = {{0, 8}, {11, 18}};
+    REQUIRE_EQ(yapdf::regexMatches(t, yapdf::Folding::Case, re, yapdf::requiredLiteral("figure \\d+")), expected);
+
+    // Without the literal, the page is skipped
+    REQUIRE(yapdf::regexMatches(t, yapdf::Folding::Case, re, "absent").empty());
+
+    SUBCASE("line by line") {
+        // `^` and `$` match at every line, and matches stop at the end of a line
+        const std::regex anchored("^\\w+$|figure 3\\s+Table", std::regex::ECMAScript | std::regex::icase);
+        const std::vector<yapdf::Match> expected = {{0, 6}, {6, 8}};
+        REQUIRE_EQ(yapdf::regexMatches(layout({"Figure", "12", "and figure 3", "Table 7"}), yapdf::Folding::Case,
+                                       anchored, ""),
+                   expected);
+    }
+
+    SUBCASE("long line") {
+        // Matched window by window rather than all at once, which would overflow the stack
+        const yapdf::PageText line = layout({std::string(200000, 'x')});
+        const std::vector<yapdf::Match> matches =
+            yapdf::regexMatches(line, yapdf::Folding::None, std::regex("x+"), "x");
+        REQUIRE_EQ(matches.size(), (200000 + yapdf::REGEX_WINDOW - 1) / yapdf::REGEX_WINDOW);
+        REQUIRE_EQ(matches.front().first, 0);
+        REQUIRE_EQ(matches.back().last, 200000);
+        for (std::size_t i = 1; i < matches.size(); ++i) {
+            REQUIRE_EQ(matches[i].first, matches[i - 1].last);
+        }
+
+        // Windows look back for word boundaries
+        REQUIRE_EQ(yapdf::regexMatches(line, yapdf::Folding::None, std::regex("\\bx"), "x").size(), 1);
+    }
+}
+
+TEST_CASE("folding") {
+    // "Ofﬁce" with a ligature glyph, "CAFÉ" and "naïve"
+    yapdf::PageText t;
+    t.text = "Of\xef\xac\x81" "ce CAF\xc3\x89 na\xc3\xafve";
+    t.offsets = {0, 1, 2, 5, 6, 8, 9, 10, 11, 14, 15, 16, 18, 19};
+    for (std::size_t i = 0; i < t.offsets.size(); ++i) {
+        t.x0.push_back(static_cast<float>(i));
+        t.y0.push_back(0);
+        t.x1.push_back(static_cast<float>(i + 1));
+        t.y1.push_back(1);
+    }
+    REQUIRE_EQ(t.view(yapdf::Folding::Case).first, "office caf\xc3\xa9 na\xc3\xafve");
+    REQUIRE_EQ(t.view(yapdf::Folding::Diacritics).first, "office cafe naive");
+
+    SUBCASE("ligature") {
+        // "fi" is one glyph, matches starting or ending inside it cover it whole
+        const std::vector<yapdf::Match> office = {{0, 5}};
+        REQUIRE_EQ(yapdf::findAll(t, "OFFICE", yapdf::Folding::Case), office);
+        const std::vector<yapdf::Match> ice = {{2, 5}};
+        REQUIRE_EQ(yapdf::findAll(t, "ice", yapdf::Folding::Case), ice);
+        REQUIRE(yapdf::findAll(t, "office", yapdf::Folding::None).empty());
+    }
+
+    SUBCASE("diacritics") {
+        const std::vector<yapdf::Match> cafe = {{5, 9}};
+        REQUIRE_EQ(yapdf::findAll(t, "caf\xc3\xa9", yapdf::Folding::Case), cafe);
+        REQUIRE(yapdf::findAll(t, "cafe", yapdf::Folding::Case).empty());
+        REQUIRE_EQ(yapdf::findAll(t, "cafe", yapdf::Folding::Diacritics), cafe);
+        REQUIRE_EQ(yapdf::findAll(t, "CAF\xc3\x89", yapdf::Folding::Diacritics), cafe);
+
+        const std::vector<yapdf::Match> naive = {{9, 14}};
+        REQUIRE_EQ(yapdf::findAll(t, "naive", yapdf::Folding::Diacritics), naive);
+    }
+
+    SUBCASE("regex") {
+        // `icase` doesn't fold "É", patterns spelling it are matched against the raw text
+        REQUIRE(yapdf::regexFolding("caf\xc3\xa9\\W", yapdf::Folding::Diacritics) == yapdf::Folding::Case);
+        REQUIRE(yapdf::regexFolding("CAF\xc3\x89", yapdf::Folding::Case) == yapdf::Folding::None);
+        REQUIRE(yapdf::regexFolding("\xce\xa3\xce\xb1", yapdf::Folding::Case) == yapdf::Folding::None);
+        REQUIRE(yapdf::regexFolding("caf\xc3\xa9", yapdf::Folding::None) == yapdf::Folding::None);
+
+        const std::vector<yapdf::Match> cafe = {{5, 9}};
+        const std::regex upper("caF\xc3\x89", std::regex::ECMAScript | std::regex::icase);
+        REQUIRE_EQ(yapdf::regexMatches(t, yapdf::Folding::None, upper, yapdf::requiredLiteral("caF\xc3\x89")), cafe);
+        const std::regex lower("caf\xc3\xa9", std::regex::ECMAScript | std::regex::icase);
+        REQUIRE_EQ(yapdf::regexMatches(t, yapdf::Folding::Case, lower, yapdf::requiredLiteral("caf\xc3\xa9")), cafe);
+    }
+}
@@ -0,0 +1,87 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "glyph_index.hpp"
+#include "links.hpp"
+#include "text_cache.hpp"
+
+namespace {
+// A page of `glyphs` glyphs on one line
+std::shared_ptr<const yapdf::PageText> page(int glyphs) {
+    auto t = std::make_shared<yapdf::PageText>();
+    for (int i = 0; i < glyphs; ++i) {
+        t->offsets.push_back(static_cast<std::uint32_t>(t->text.size()));
+        t->x0.push_back(static_cast<float>(i));
+        t->y0.push_back(0);
+        t->x1.push_back(static_cast<float>(i + 1));
+        t->y1.push_back(1);
+        t->text.push_back('x');
+    }
+    return t;
+}
+} // namespace
+
+TEST_CASE("hits") {
+    yapdf::TextCache cache(4, 1 << 20);
+    REQUIRE_FALSE(cache.find(0).text);
+
+    const std::shared_ptr<const yapdf::PageText> t = page(10);
+    REQUIRE_EQ(cache.insert(0, t), t);
+    REQUIRE_EQ(cache.find(0).text, t);
+    REQUIRE_EQ(cache.usage(), t->bytes());
+
+    // The text cached first wins over a concurrent extraction
+    REQUIRE_EQ(cache.insert(0, page(10)), t);
+    REQUIRE_EQ(cache.usage(), t->bytes());
+
+    // Derived entries are attached to the cached text only
+    const auto idx = std::make_shared<const yapdf::GlyphIndex>(t);
+    REQUIRE_EQ(cache.insert(0, t, idx), idx);
+    REQUIRE_EQ(cache.find(0).glyphs, idx);
+    REQUIRE_EQ(cache.insert(0, t, std::make_shared<const yapdf::GlyphIndex>(t)), idx);
+
+    const std::shared_ptr<const yapdf::PageText> other = page(10);
+    const auto links = std::make_shared<const yapdf::LinkMap>(yapdf::LinkMap::extract(*other));
+    REQUIRE_EQ(cache.insert(0, other, links), links);
+    REQUIRE_FALSE(cache.find(0).links);
+}
+
+TEST_CASE("eviction") {
+    const std::size_t bytes = page(100)->bytes();
+    yapdf::TextCache cache(4, 2 * bytes);
+    for (int i = 0; i < 2; ++i) {
+        const std::shared_ptr<const yapdf::PageText> t = cache.insert(i, page(100));
+        cache.insert(i, t, std::make_shared<const yapdf::GlyphIndex>(t));
+    }
+
+    // Page 1 is the least recently used
+    REQUIRE(cache.find(0).text);
+    cache.insert(2, page(100));
+    REQUIRE_EQ(cache.usage(), 2 * bytes);
+    REQUIRE(cache.find(0).text);
+    REQUIRE(cache.find(2).text);
+
+    // Evicted with its text, and extracted again on the next use
+    const yapdf::TextCache::Entry evicted = cache.find(1);
+    REQUIRE_FALSE(evicted.text);
+    REQUIRE_FALSE(evicted.glyphs);
+    const std::shared_ptr<const yapdf::PageText> t = cache.insert(1, page(100));
+    REQUIRE_FALSE(cache.find(1).glyphs);
+    REQUIRE_FALSE(cache.find(0).text);
+
+    // A stale text doesn't get an index attached
+    const std::shared_ptr<const yapdf::PageText> stale = page(100);
+    cache.insert(1, stale, std::make_shared<const yapdf::GlyphIndex>(stale));
+    REQUIRE_FALSE(cache.find(1).glyphs);
+    REQUIRE_EQ(cache.find(1).text, t);
+
+    // A page over budget is kept alone
+    cache.insert(3, page(1000));
+    REQUIRE(cache.find(3).text);
+    REQUIRE_FALSE(cache.find(1).text);
+    REQUIRE_FALSE(cache.find(2).text);
+    REQUIRE_EQ(cache.usage(), cache.find(3).text->bytes());
+}
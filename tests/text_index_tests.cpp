@@ -0,0 +1,143 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "text_index.hpp"
+
+namespace {
+// An index file in the temporary directory, removed afterwards
+class TempFile {
+public:
+    explicit TempFile(const std::string& name)
+        : path_(std::filesystem::temp_directory_path() / (name + "-" + std::to_string(::getpid()) + ".idx")) {
+        std::filesystem::remove(path_);
+    }
+
+    ~TempFile() {
+        std::filesystem::remove(path_);
+    }
+
+    [[nodiscard]] std::string path() const {
+        return path_.string();
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+std::vector<std::pair<std::string, std::size_t>> words(std::string_view text) {
+    std::vector<std::pair<std::string, std::size_t>> out;
+    yapdf::TextIndex::tokenize(text, [&](std::string_view w, std::size_t offset) { out.emplace_back(w, offset); });
+    return out;
+}
+
+// Index `pages`, glyphs are numbered like bytes
+yapdf::TextIndex::Postings postings(const std::vector<std::string>& pages, std::uint32_t first) {
+    yapdf::TextIndex::Postings out;
+    for (std::size_t i = 0; i < pages.size(); ++i) {
+        std::uint32_t position = 0;
+        for (const auto& [w, offset] : words(pages[i])) {
+            std::string folded = w;
+            for (char& c : folded) {
+                c = static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+            }
+            out[folded].push_back({first + static_cast<std::uint32_t>(i), position++,
+                                   static_cast<std::uint32_t>(offset)});
+        }
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("tokenize") {
+    const std::vector<std::pair<std::string, std::size_t>> expected = {
+        {"Hello", 0}, {"w0rld", 7}, {"caf\xc3\xa9", 15}};
+    REQUIRE_EQ(words("Hello, w0rld! (caf\xc3\xa9)"), expected);
+    REQUIRE(words(" ,.; ").empty());
+
+    // "PDF文档。中文" splits into a word and bigrams, ending each run with its last character
+    const std::vector<std::pair<std::string, std::size_t>> cjk = {{"PDF", 0},
+                                                                  {"\xe6\x96\x87\xe6\xa1\xa3", 3},
+                                                                  {"\xe6\xa1\xa3", 6},
+                                                                  {"\xe4\xb8\xad\xe6\x96\x87", 12},
+                                                                  {"\xe6\x96\x87", 15}};
+    REQUIRE_EQ(words("PDF\xe6\x96\x87\xe6\xa1\xa3\xe3\x80\x82\xe4\xb8\xad\xe6\x96\x87"), cjk);
+
+    // "中文，文档（Ｐ）" splits at fullwidth punctuation, fullwidth letters are words
+    const std::vector<std::pair<std::string, std::size_t>> fullwidth = {{"\xe4\xb8\xad\xe6\x96\x87", 0},
+                                                                        {"\xe6\x96\x87", 3},
+                                                                        {"\xe6\x96\x87\xe6\xa1\xa3", 9},
+                                                                        {"\xe6\xa1\xa3", 12},
+                                                                        {"\xef\xbc\xb0", 18}};
+    REQUIRE_EQ(words("\xe4\xb8\xad\xe6\x96\x87\xef\xbc\x8c\xe6\x96\x87\xe6\xa1\xa3"
+                     "\xef\xbc\x88\xef\xbc\xb0\xef\xbc\x89"),
+               fullwidth);
+}
+
+TEST_CASE("find") {
+    const TempFile file("yapdf-text-index");
+    const std::string path = file.path();
+    yapdf::TextIndex::write(path, 42,
+                            {postings({"The quick brown fox", "jumps over the lazy dog"}, 0),
+                             postings({"the QUICK fox", "quick brown"}, 2)});
+
+    REQUIRE_THROWS_AS(yapdf::TextIndex(path, 43), std::runtime_error);
+
+    const yapdf::TextIndex index(path, 42);
+    REQUIRE_EQ(index.terms(), 8);
+
+    SUBCASE("word") {
+        const std::vector<yapdf::TextIndex::Posting> found = index.find("quick");
+        REQUIRE_EQ(found.size(), 3);
+        REQUIRE_EQ(found[0].page, 0);
+        REQUIRE_EQ(found[0].glyph, 4);
+        REQUIRE_EQ(found[1].page, 2);
+        REQUIRE_EQ(found[2].page, 3);
+        REQUIRE_EQ(found[2].position, 0);
+    }
+
+    SUBCASE("phrase") {
+        const std::vector<yapdf::TextIndex::Posting> found = index.find("Quick, brown");
+        REQUIRE_EQ(found.size(), 2);
+        REQUIRE_EQ(found[0].page, 0);
+        REQUIRE_EQ(found[1].page, 3);
+
+        // Phrases don't span pages
+        REQUIRE(index.find("fox jumps").empty());
+        REQUIRE(index.find("quick cat").empty());
+        REQUIRE(index.find("").empty());
+    }
+}
+
+TEST_CASE("find CJK") {
+    // "中文文档", "文档格式" and "中文"
+    const TempFile file("yapdf-text-index-cjk");
+    const std::string path = file.path();
+    yapdf::TextIndex::write(path, 42,
+                            {postings({"\xe4\xb8\xad\xe6\x96\x87\xe6\x96\x87\xe6\xa1\xa3",
+                                       "\xe6\x96\x87\xe6\xa1\xa3\xe6\xa0\xbc\xe5\xbc\x8f",
+                                       "\xe4\xb8\xad\xe6\x96\x87"},
+                                      0)});
+    const yapdf::TextIndex index(path, 42);
+
+    // "文档" is found inside runs, and a single character anywhere
+    const std::vector<yapdf::TextIndex::Posting> doc = index.find("\xe6\x96\x87\xe6\xa1\xa3");
+    REQUIRE_EQ(doc.size(), 2);
+    REQUIRE_EQ(doc[0].page, 0);
+    REQUIRE_EQ(doc[0].glyph, 6);
+    REQUIRE_EQ(doc[1].page, 1);
+    REQUIRE_EQ(doc[1].glyph, 0);
+    REQUIRE_EQ(index.find("\xe6\x96\x87").size(), 4);
+
+    // "中文" ends the last page but not the first
+    REQUIRE_EQ(index.find("\xe4\xb8\xad\xe6\x96\x87").size(), 2);
+    REQUIRE_EQ(index.find("\xe4\xb8\xad\xe6\x96\x87\xe6\x96\x87").size(), 1);
+    REQUIRE(index.find("\xe6\xa1\xa3\xe4\xb8\xad").empty());
+}
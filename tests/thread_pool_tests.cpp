@@ -0,0 +1,87 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "cancellation.hpp"
+#include "thread_pool.hpp"
+
+TEST_CASE("submit") {
+    yapdf::ThreadPool pool(4);
+    REQUIRE_EQ(pool.size(), 4u);
+
+    std::vector<std::future<int>> futs;
+    for (int i = 0; i < 100; ++i) {
+        futs.push_back(pool.submit([i] { return i * i; }));
+    }
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE_EQ(futs[i].get(), i * i);
+    }
+}
+
+TEST_CASE("exception") {
+    yapdf::ThreadPool pool(1);
+    auto fut = pool.submit([]() -> int { throw std::runtime_error("oops"); });
+    REQUIRE_THROWS_AS(fut.get(), std::runtime_error);
+}
+
+TEST_CASE("cancellation") {
+    yapdf::ThreadPool pool(1);
+    const yapdf::CancellationToken token;
+
+    std::atomic<bool> started(false);
+    auto fut = pool.submit([token, &started] {
+        started = true;
+        int n = 0;
+        while (!token.cancelled()) {
+            ++n;
+        }
+        return n;
+    });
+
+    while (!started) {
+    }
+
+    // all copies share the same flag
+    const yapdf::CancellationToken copy = token;
+    copy.cancel();
+    REQUIRE(token.cancelled());
+    REQUIRE_GE(fut.get(), 0);
+}
+
+TEST_CASE("priority") {
+    yapdf::ThreadPool pool(1);
+
+    // hold the only worker until all jobs are queued
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    pool.post([opened] { opened.wait(); }, yapdf::Priority::High);
+
+    std::mutex mu;
+    std::vector<int> order;
+    const auto record = [&](int i) {
+        return [&, i] {
+            std::lock_guard<std::mutex> lock(mu);
+            order.push_back(i);
+        };
+    };
+
+    pool.post(record(0), yapdf::Priority::Low);
+    auto raised = pool.post(record(1), yapdf::Priority::Low);
+    pool.post(record(2), yapdf::Priority::Normal);
+    pool.raise(raised, yapdf::Priority::High);
+
+    // lowering is ignored
+    pool.raise(raised, yapdf::Priority::Low);
+
+    auto last = pool.submit([] {}, yapdf::Priority::Low);
+    gate.set_value();
+    last.get();
+
+    const std::vector<int> expected = {1, 2, 0};
+    REQUIRE_EQ(order, expected);
+}